@@ -20,3 +20,5 @@ HEADERS  += mainwindow.h \
     deserializer.h
 
 FORMS    += mainwindow.ui
+
+LIBS     += -lz
@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Times the parser on the different inputs
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = bench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += main.cpp \
+    ../deserializer.cpp
+
+HEADERS  += ../deserializer.h
+
+LIBS     += -lz
@@ -0,0 +1,449 @@
+#include "deserializer.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <zlib.h>
+
+// bench gzip file.gz
+//     parses the file inflating it on the fly
+//     against inflating it to a file first and parsing that
+//
+// bench inputs file.bin
+//     parses the file through each input
+//     against an input that reads every field through the virtual readBytes
+//     then reads the whole file as int32 fields through each input
+//     which leaves out the cost of building the records
+//
+// bench list file.bin [chain]
+//     writes a List<SmallClass> of 100k and then 1M objects to the file
+//     and parses each, the time per object should stay the same
+//     with chain each ClassWithId takes its metadata from the one before
+//
+// bench sparse
+//     parses an object[] of 100M elements with two values at the start
+//     and the rest one null run, as the _items of a List<T>
+//     fails if the stream takes more than SPARSE_MEMORY_LIMIT bytes
+//
+// each case runs a few times and the best time is printed
+
+#define BENCH_RUNS 3
+
+// ==========================================
+// helpers
+// ==========================================
+
+class TVirtualMemoryInput : public TBinaryInput
+{
+public:
+    // reads from memory like TMemoryInput but leaves the window empty
+    // so every field takes the virtual call as the inputs used to
+
+    const char* data;
+    qint64 size;
+    qint64 pos;
+
+    TVirtualMemoryInput(const char* buffer, qint64 length) { data = buffer; size = length; pos = 0; }
+    bool readBytes(char* buffer, int count) override {
+        if(count < 0 || count > size - pos) return false;
+        memcpy(buffer, data + pos, count);
+        pos += count;
+        return true;
+    }
+};
+
+static void printTime(QTextStream& out, const char* name, qint64 nsecs)
+{
+    QString line;
+    line.sprintf("%-24s %10.1f ms\n", name, nsecs / 1000000.0);
+    out << line;
+}
+
+static bool parse(TBinaryInput& input)
+{
+    TDeserializer deserializer;
+    return deserializer.read(input) == DESERIAL_OK;
+}
+
+static bool readInts(TBinaryInput& input)
+{
+    // the sink keeps the reads from being optimised away
+    qint32 value;
+    volatile qint32 sink = 0;
+    while(input.readI32(value)) sink = sink + value;
+    return true;
+}
+
+static bool inflateFile(QString& filename, QString& outname)
+{
+    gzFile in = gzopen(filename.toLocal8Bit().constData(), "rb");
+    if(in == NULL) return false;
+
+    QFile outfile(outname);
+    if(!outfile.open(QIODevice::WriteOnly)) {
+        gzclose(in);
+        return false;
+    }
+
+    char* block = new char[INPUT_BLOCK_SIZE];
+    int n;
+    while((n = gzread(in, block, INPUT_BLOCK_SIZE)) > 0) {
+        outfile.write(block, n);
+    }
+    delete[] block;
+    gzclose(in);
+    outfile.close();
+    return n == 0;
+}
+
+// ==========================================
+// gzip
+// ==========================================
+
+static int benchGzip(QString& filename, QTextStream& out)
+{
+    QString rawname = filename + ".bench";
+    qint64 best[3] = { -1, -1, -1 };
+
+    for(int run=0; run<BENCH_RUNS; run++) {
+        QElapsedTimer timer;
+
+        // --------- on the fly ------------
+        timer.start();
+        TGzipFileInput gzipInput(filename);
+        if(!gzipInput.open() || !parse(gzipInput)) return 1;
+        qint64 onTheFly = timer.nsecsElapsed();
+
+        // --------- inflate first ------------
+        timer.start();
+        if(!inflateFile(filename, rawname)) return 1;
+        qint64 inflated = timer.nsecsElapsed();
+
+        TBufferedFileInput fileInput(rawname);
+        if(!fileInput.open() || !parse(fileInput)) return 1;
+        qint64 total = timer.nsecsElapsed();
+
+        qint64 times[3] = { onTheFly, inflated, total };
+        for(int i=0; i<3; i++) {
+            if(best[i] < 0 || times[i] < best[i]) best[i] = times[i];
+        }
+    }
+    QFile::remove(rawname);
+
+    printTime(out, "inflate on the fly", best[0]);
+    printTime(out, "inflate to file", best[1]);
+    printTime(out, "inflate then parse", best[2]);
+    return 0;
+}
+
+// ==========================================
+// inputs
+// ==========================================
+
+#define BENCH_INPUTS 5
+
+static TBinaryInput* makeInput(int kind, QString& filename, QByteArray& bytes)
+{
+    switch(kind) {
+        case 0: return new TVirtualMemoryInput(bytes.constData(), bytes.size());
+        case 1: return new TMemoryInput(bytes);
+        case 2: {
+            TMappedFileInput* input = new TMappedFileInput(filename);
+            if(!input->open()) { delete input; return NULL; }
+            return input;
+        }
+        case 3: {
+            TBufferedFileInput* input = new TBufferedFileInput(filename);
+            if(!input->open()) { delete input; return NULL; }
+            return input;
+        }
+        case 4: {
+            TFileInput* input = new TFileInput(filename);
+            if(!input->open()) { delete input; return NULL; }
+            return input;
+        }
+    }
+    return NULL;
+}
+
+static int benchInputs(QString& filename, QTextStream& out)
+{
+    static const char* names[BENCH_INPUTS] = {
+        "virtual memory", "TMemoryInput", "TMappedFileInput", "TBufferedFileInput", "TFileInput" };
+
+    QFile infile(filename);
+    if(!infile.open(QFile::ReadOnly)) return 1;
+    QByteArray bytes = infile.readAll();
+    infile.close();
+
+    for(int pass=0; pass<2; pass++) {
+        out << (pass == 0 ? "parse\n" : "read int32\n");
+
+        for(int kind=0; kind<BENCH_INPUTS; kind++) {
+            qint64 best = -1;
+            for(int run=0; run<BENCH_RUNS; run++) {
+                QElapsedTimer timer;
+                timer.start();
+                TBinaryInput* input = makeInput(kind, filename, bytes);
+                if(input == NULL) return 1;
+                bool ok = pass == 0 ? parse(*input) : readInts(*input);
+                delete input;
+                if(!ok) return 1;
+
+                qint64 time = timer.nsecsElapsed();
+                if(best < 0 || time < best) best = time;
+            }
+            printTime(out, names[kind], best);
+        }
+    }
+    return 0;
+}
+
+// ==========================================
+// list
+// ==========================================
+
+static void putI32(QByteArray& out, qint32 value)
+{
+    for(int i=0; i<4; i++) out.append((char)(value >> (8 * i)));
+}
+
+static void putString(QByteArray& out, const QString& str)
+{
+    // length as a 7 bit variable int, then UTF-8
+    QByteArray bytes = str.toUtf8();
+    quint32 n = bytes.size();
+    while(n >= 0x80) {
+        out.append((char)(n | 0x80));
+        n >>= 7;
+    }
+    out.append((char)n);
+    out.append(bytes);
+}
+
+static void makeList(QByteArray& out, qint32 count, bool chain)
+{
+    // TestClass { int singleint; List<SmallClass> classlist; }
+    // SmallClass { int smallint; string name; }
+    const qint32 firstItem = 6;
+    QString listName = "System.Collections.Generic.List`1[[DeserialTest.SmallClass]]";
+
+    // --------- header and library ------------
+    out.append((char)0x00);
+    putI32(out, 1); putI32(out, -1); putI32(out, 1); putI32(out, 0);
+    out.append((char)0x0c);
+    putI32(out, 2);
+    putString(out, "Deserializer, Version=1.0.0.0, Culture=neutral, PublicKeyToken=null");
+
+    // --------- TestClass ------------
+    out.append((char)0x05);
+    putI32(out, 1);
+    putString(out, "DeserialTest.TestClass");
+    putI32(out, 2);
+    putString(out, "singleint");
+    putString(out, "classlist");
+    out.append((char)0x00); out.append((char)0x03);
+    out.append((char)0x08);
+    putString(out, listName);
+    putI32(out, 2);
+    putI32(out, 123);
+    out.append((char)0x09);
+    putI32(out, 4);
+
+    // --------- List ------------
+    out.append((char)0x04);
+    putI32(out, 4);
+    putString(out, listName);
+    putI32(out, 3);
+    putString(out, "_items"); putString(out, "_size"); putString(out, "_version");
+    out.append((char)0x04); out.append((char)0x00); out.append((char)0x00);
+    putString(out, "DeserialTest.SmallClass");
+    putI32(out, 2);
+    out.append((char)0x08); out.append((char)0x08);
+    out.append((char)0x09);
+    putI32(out, 5);
+    putI32(out, count);
+    putI32(out, count);
+
+    // --------- _items, half as much room again left null ------------
+    qint32 capacity = count + count / 2;
+    out.append((char)0x07);
+    putI32(out, 5);
+    out.append((char)0x00);
+    putI32(out, 1);
+    putI32(out, capacity);
+    out.append((char)0x04);
+    putString(out, "DeserialTest.SmallClass");
+    putI32(out, 2);
+    for(qint32 i=0; i<count; i++) {
+        out.append((char)0x09);
+        putI32(out, firstItem + i);
+    }
+    if(capacity > count) {
+        out.append((char)0x0e);
+        putI32(out, capacity - count);
+    }
+
+    // --------- SmallClass objects ------------
+    out.append((char)0x05);
+    putI32(out, firstItem);
+    putString(out, "DeserialTest.SmallClass");
+    putI32(out, 2);
+    putString(out, "smallint");
+    putString(out, "name");
+    out.append((char)0x00); out.append((char)0x01);
+    out.append((char)0x08);
+    putI32(out, 2);
+    putI32(out, 0);
+    out.append((char)0x06);
+    putI32(out, 1000000000);
+    putString(out, "item0");
+
+    for(qint32 i=1; i<count; i++) {
+        out.append((char)0x01);
+        putI32(out, firstItem + i);
+        putI32(out, chain ? firstItem + i - 1 : firstItem);
+        putI32(out, i * 10);
+        out.append((char)0x06);
+        putI32(out, 1000000000 + i);
+        putString(out, "item" + QString::number(i));
+    }
+
+    out.append((char)0x0b);
+}
+
+static int benchList(QString& filename, bool chain, QTextStream& out)
+{
+    static const qint32 counts[2] = { 100000, 1000000 };
+
+    for(int i=0; i<2; i++) {
+        QByteArray bytes;
+        makeList(bytes, counts[i], chain);
+
+        QFile outfile(filename);
+        if(!outfile.open(QIODevice::WriteOnly)) return 1;
+        outfile.write(bytes);
+        outfile.close();
+
+        qint64 best = -1;
+        for(int run=0; run<BENCH_RUNS; run++) {
+            QElapsedTimer timer;
+            timer.start();
+            TBufferedFileInput input(filename);
+            if(!input.open() || !parse(input)) return 1;
+
+            qint64 time = timer.nsecsElapsed();
+            if(best < 0 || time < best) best = time;
+        }
+
+        QString line;
+        line.sprintf("%-8d objects %10.1f ms %8.1f ns per object\n",
+                     counts[i], best / 1000000.0, (double)best / counts[i]);
+        out << line;
+    }
+    return 0;
+}
+
+// ==========================================
+// sparse
+// ==========================================
+
+#define SPARSE_LENGTH 100000000
+#define SPARSE_MEMORY_LIMIT 1000000
+
+static void makeSparse(QByteArray& out, bool objects)
+{
+    out.append((char)0x00);
+    putI32(out, 1); putI32(out, -1); putI32(out, 1); putI32(out, 0);
+
+    // ArraySingleObject, two values then ObjectNullMultiple
+    out.append((char)0x10);
+    putI32(out, 1);
+    putI32(out, SPARSE_LENGTH);
+    for(int i=0; i<2; i++) {
+        if(objects) {
+            out.append((char)0x06);
+            putI32(out, 2 + i);
+            putString(out, "item" + QString::number(i));
+        }
+        else {
+            out.append((char)0x08);
+            out.append((char)0x08);
+            putI32(out, i + 1);
+        }
+    }
+    out.append((char)0x0e);
+    putI32(out, SPARSE_LENGTH - 2);
+
+    out.append((char)0x0b);
+}
+
+static int benchSparse(QTextStream& out, QTextStream& err)
+{
+    int result = 0;
+    for(int kind=0; kind<2; kind++) {
+        QByteArray bytes;
+        makeSparse(bytes, kind == 1);
+
+        QElapsedTimer timer;
+        timer.start();
+        TMemoryInput input(bytes);
+        TDeserializer deserializer;
+        if(deserializer.read(input) != DESERIAL_OK) {
+            err << "Failed to parse sparse array\n";
+            return 1;
+        }
+        qint64 time = timer.nsecsElapsed();
+        qint64 used = deserializer.memoryUsed();
+
+        QString line;
+        line.sprintf("%-24s %10.1f ms %10lld bytes\n",
+                     kind == 1 ? "two strings" : "two int32", time / 1000000.0, used);
+        out << line;
+
+        if(used > SPARSE_MEMORY_LIMIT) {
+            err << "Sparse array takes more than " << SPARSE_MEMORY_LIMIT << " bytes\n";
+            result = 1;
+        }
+    }
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QStringList args = a.arguments();
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    int result = -1;
+    if(args.count() == 3 && args.at(1) == "gzip") {
+        QString filename = args.at(2);
+        result = benchGzip(filename, out);
+    }
+    else if(args.count() == 3 && args.at(1) == "inputs") {
+        QString filename = args.at(2);
+        result = benchInputs(filename, out);
+    }
+    else if((args.count() == 3 || (args.count() == 4 && args.at(3) == "chain")) && args.at(1) == "list") {
+        QString filename = args.at(2);
+        result = benchList(filename, args.count() == 4, out);
+    }
+    else if(args.count() == 2 && args.at(1) == "sparse") {
+        return benchSparse(out, err);
+    }
+
+    if(result < 0) {
+        err << "usage: bench gzip file.gz\n"
+               "       bench inputs file.bin\n"
+               "       bench list file.bin [chain]\n"
+               "       bench sparse\n";
+        return 1;
+    }
+    if(result > 0) {
+        err << "Failed to parse " << args.at(2) << "\n";
+    }
+    return result;
+}
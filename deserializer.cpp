@@ -1,28 +1,240 @@
 #include "deserializer.h"
-
-TBinaryType* getBinaryType(char code);
-TPrimitiveType* getPrimitiveType(char code);
-TPrimitiveType* getArrayType(char code, int len);
-TFileRecord* getRecordType(char code);
+#include <QThread>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QtEndian>
+#include <zlib.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+TBinaryType* getBinaryType(char code, TArena* arena);
+TPrimitiveType* getPrimitiveType(char code, TArena* arena);
+TPrimitiveType* getArrayType(char code, int len, TArena* arena);
+TFileRecord* getRecordType(char code, TArena* arena);
 void indentOutput(QTextStream& outstr, int indent);
-TFileRecord* getRecord(qint32 id, QList<TFileRecord*>& recordList);
+TClassSchema* addSchema(TFileRecord* record, TBinaryInput& input, TRecordList& recordList);
+void decodeString(const char* data, int size, QString& str);
+void normaliseBools(char* data, int count);
+
+
+// ==========================================
+// TArena
+// ==========================================
+
+// in front of every TArenaObject, 8 bytes to keep the object aligned
+// the first 4 are where it was allocated, the next 4 its size
+#define ARENA_TAG_SIZE 8
+#define ARENA_TAG_HEAP 0
+#define ARENA_TAG_ARENA 1
+#define ARENA_TAG_PLAIN 2
+
+TArena::TArena() {
+    pos = NULL;
+    end = NULL;
+    used = 0;
+    reserved = 0;
+}
+
+TArena::~TArena() {
+    release();
+}
+
+void* TArena::allocate(size_t size) {
+    size = (size + 7) & ~(size_t)7;
+
+    if((size_t)(end - pos) < size) {
+        // large requests get a block of their own
+        // so the current block can still be filled
+        if(size > ARENA_BLOCK_SIZE / 4) {
+            char* block = new char[size];
+            blocks.append(block);
+            used += size;
+            reserved += size;
+            return block;
+        }
+
+        pos = new char[ARENA_BLOCK_SIZE];
+        end = pos + ARENA_BLOCK_SIZE;
+        blocks.append(pos);
+        reserved += ARENA_BLOCK_SIZE;
+    }
+
+    void* result = pos;
+    pos += size;
+    used += size;
+    return result;
+}
+
+void TArena::release() {
+    for(int i=0; i<blocks.count(); i++) {
+        delete[] blocks.at(i);
+    }
+    blocks.clear();
+    pos = NULL;
+    end = NULL;
+    used = 0;
+    reserved = 0;
+}
+
+void* TArenaObject::operator new(size_t size) {
+    return operator new(size, (TArena*)NULL);
+}
+
+void* TArenaObject::operator new(size_t size, TArena* arena) {
+    char* p;
+    if(arena != NULL) {
+        p = (char*)arena->allocate(size + ARENA_TAG_SIZE);
+        *(qint32*)p = ARENA_TAG_ARENA;
+    }
+    else {
+        p = (char*)malloc(size + ARENA_TAG_SIZE);
+        if(p == NULL) throw std::bad_alloc();
+        *(qint32*)p = ARENA_TAG_HEAP;
+    }
+    *(quint32*)(p + 4) = (quint32)size;
+    return p + ARENA_TAG_SIZE;
+}
+
+void TArenaObject::operator delete(void* p) {
+    // arena memory goes when the arena is released
+    if(p == NULL) return;
+    char* tag = (char*)p - ARENA_TAG_SIZE;
+    if(*(qint32*)tag == ARENA_TAG_HEAP) {
+        free(tag);
+    }
+}
+
+void TArenaObject::operator delete(void* p, TArena*) {
+    // only called if a constructor throws
+    operator delete(p);
+}
+
+bool TArenaObject::isPlain(const void* p) {
+    return *(const qint32*)((const char*)p - ARENA_TAG_SIZE) == ARENA_TAG_PLAIN;
+}
+
+void TArenaObject::setPlain(bool plain) {
+    qint32* tag = (qint32*)((char*)this - ARENA_TAG_SIZE);
+    if(*tag != ARENA_TAG_HEAP) *tag = plain ? ARENA_TAG_PLAIN : ARENA_TAG_ARENA;
+}
+
+qint64 TArenaObject::nodeSize(const void* p) {
+    // as allocated, tag included
+    const char* tag = (const char*)p - ARENA_TAG_SIZE;
+    return ((*(const quint32*)(tag + 4) + 7) & ~7) + ARENA_TAG_SIZE;
+}
+
+// ==========================================
+// TNameTable
+// ==========================================
+
+qint32 TNameTable::intern(const QString& str) {
+    QHash<QString, qint32>::const_iterator it = ids.constFind(str);
+    if(it != ids.constEnd()) return it.value();
+
+    qint32 id = names.count();
+    names.append(str);
+    ids.insert(str, id);
+
+    // entry in names, node in ids and the characters they share
+    bytes += 2 * sizeof(QString) + sizeof(qint32) + str.size() * sizeof(QChar);
+    return id;
+}
+
+qint32 TNameTable::find(const QString& str) {
+    return ids.value(str, -1);
+}
+
+QString TNameTable::name(qint32 id) {
+    if(id < 0 || id >= names.count()) return QString();
+    return names.at(id);
+}
+
+int TNameTable::count() {
+    return names.count();
+}
+
+void TNameTable::clear() {
+    names.clear();
+    ids.clear();
+    bytes = 0;
+}
+
+// ==========================================
+// TRecordList
+// ==========================================
+
+void TRecordList::updateIndex() {
+    // add the records appended since the last call
+    // references are not objects and 0 is no id
+    for(; indexed < count(); indexed++) {
+        TFileRecord* record = at(indexed);
+        qint32 id = record->objectID;
+        if(id == 0 || record->type == 9) continue;
+        if(findIndexed(id) != NULL) continue;
+
+        if(id > 0 && id <= 2 * indexed + 1024) {
+            if(id >= denseIds.count()) denseIds.resize(id + 1);
+            denseIds[id] = record;
+        }
+        else {
+            ids.insert(id, record);
+        }
+    }
+}
+
+TFileRecord* TRecordList::findIndexed(qint32 id) {
+    // an id may be in ids if it was past denseIds when indexed
+    if(id > 0 && id < denseIds.count()) {
+        TFileRecord* record = denseIds.at(id);
+        if(record != NULL) return record;
+    }
+    if(ids.isEmpty()) return NULL;
+    return ids.value(id, NULL);
+}
+
+TFileRecord* TRecordList::find(qint32 id) {
+    // also finds records appended while an earlier one is still being read
+    updateIndex();
+    return findIndexed(id);
+}
 
+void TRecordList::clearIndex() {
+    denseIds.clear();
+    ids.clear();
+    indexed = 0;
+}
 
 // ==========================================
 // TClassInfo
 // ==========================================
 
-bool TClassInfo::read(TBinaryInput& input) {
-    if(!input.readBytes((char*)&objectID, 4)) return false;
+TClassInfo::TClassInfo() {
+    objectID = 0;
+    nameID = -1;
+    displayNameID = -1;
+    names = NULL;
+}
+
+bool TClassInfo::read(TBinaryInput& input, TNameTable& table) {
+    names = &table;
+
+    QString name;
+    if(!input.readI32(objectID)) return false;
     if(!input.readString(name)) return false;
     qint32 membercount;
-    if(!input.readBytes((char*)&membercount, 4)) return false;
+    if(!input.readI32(membercount)) return false;
+    if(membercount < 0) return false;
+    memberIDs.reserve(membercount);
     for(int i=0; i<membercount; i++) {
         QString str;
         if(!input.readString(str)) return false;
-        memberNames.append(str);
+        memberIDs.append(table.intern(str));
     }
 
+    QString displayName;
+
     // remove [[version info]]
     int pos = name.indexOf("[[");
     if(pos >= 0) {
@@ -38,162 +250,810 @@ bool TClassInfo::read(TBinaryInput& input) {
         displayName = name.left(pos);
     }
 
+    nameID = table.intern(name);
+    displayNameID = table.intern(displayName);
+
     return true;
 }
 
+void TClassInfo::setName(TNameTable& table, const QString& str) {
+    names = &table;
+    nameID = table.intern(str);
+    displayNameID = nameID;
+}
+
+QString TClassInfo::name() {
+    if(names == NULL) return QString();
+    return names->name(nameID);
+}
+
+QString TClassInfo::displayName() {
+    if(names == NULL) return QString();
+    return names->name(displayNameID);
+}
+
+QString TClassInfo::memberName(int i) {
+    if(names == NULL || i < 0 || i >= memberIDs.count()) return QString();
+    return names->name(memberIDs.at(i));
+}
+
+int TClassInfo::memberIndex(const QString& str) {
+    // compare ids rather than strings
+    if(names == NULL) return -1;
+    qint32 id = names->find(str);
+    if(id < 0) return -1;
+    return memberIDs.indexOf(id);
+}
+
 void TClassInfo::write(QTextStream& outstr, int indent)
 {
     outstr << "ClassInfo objectID:" << objectID;
-    outstr <<  " displayName:" << displayName;
+    outstr <<  " displayName:" << displayName();
     outstr <<  "\n";
 
-    for(int i=0; i<memberNames.count(); i++) {
+    for(int i=0; i<memberIDs.count(); i++) {
         indentOutput(outstr, indent+1);
-        outstr << memberNames.at(i) << "\n";
+        outstr << memberName(i) << "\n";
     }
 }
 
 // ==========================================
-// PrimitiveTypeEnumeration
+// TDecimal
 // ==========================================
 
-// --------- 1 ------------
-bool TPrimitiveBoolean::read(TBinaryInput& input){
-    char c;
-    if(!input.readBytes(&c, 1)) return false;
-    value = (c != 0);
+TDecimal::TDecimal() {
+    lo = 0;
+    mid = 0;
+    hi = 0;
+    scale = 0;
+    negative = false;
+}
+
+bool TDecimal::mulAdd(quint32 digit) {
+    // mantissa = mantissa * 10 + digit
+    // left unchanged if the result needs more than 96 bits
+    quint64 t = (quint64)lo * 10 + digit;
+    quint32 newLo = (quint32)t;
+    t = (quint64)mid * 10 + (t >> 32);
+    quint32 newMid = (quint32)t;
+    t = (quint64)hi * 10 + (t >> 32);
+    if(t >> 32) return false;
+
+    lo = newLo;
+    mid = newMid;
+    hi = (quint32)t;
     return true;
 }
-void TPrimitiveBoolean::write(QTextStream& outstr){
 
-    if(value) {
-        outstr << "true";
-    }
-    else {
-        outstr << "false";
+bool TDecimal::parse(const char* str, int size) {
+    // [-]digits[.digits] as written by Decimal.ToString
+    // fraction digits beyond what fits are rounded off like Decimal.Parse
+    *this = TDecimal();
+
+    int i = 0;
+    if(i < size && (str[i] == '-' || str[i] == '+')) {
+        negative = (str[i] == '-');
+        i++;
+    }
+
+    int digits = 0;
+    while(i < size && str[i] >= '0' && str[i] <= '9') {
+        if(!mulAdd(str[i] - '0')) return false;
+        digits++;
+        i++;
+    }
+
+    if(i < size && str[i] == '.') {
+        i++;
+        bool full = false;
+        bool roundUp = false;
+        while(i < size && str[i] >= '0' && str[i] <= '9') {
+            if(!full) {
+                if(scale < 28 && mulAdd(str[i] - '0')) {
+                    scale++;
+                }
+                else {
+                    full = true;
+                    roundUp = (str[i] >= '5');
+                }
+            }
+            digits++;
+            i++;
+        }
+        if(roundUp && (lo & mid & hi) != 0xFFFFFFFF) {
+            // add one to the last kept digit
+            if(++lo == 0 && ++mid == 0) ++hi;
+        }
     }
+
+    return (digits > 0 && i == size);
 }
-void TPrimitiveBoolean::writeType(QTextStream& outstr){
-    outstr << " (bool) ";
+
+double TDecimal::toDouble() const {
+    static const double powers[29] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+        1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+        1e20, 1e21, 1e22, 1e23, 1e24, 1e25, 1e26, 1e27, 1e28
+    };
+
+    double m = hi * 18446744073709551616.0 + mid * 4294967296.0 + lo;
+    if(scale > 0 && scale <= 28) m /= powers[scale];
+    return negative ? -m : m;
 }
 
-// --------- 2 ------------
-bool TPrimitiveByte::read(TBinaryInput& input){
-    if(!input.readBytes(&value, 1)) return false;
-    return true;
+QString TDecimal::toString() const {
+    // digits by repeated division of the mantissa by 10
+    char buffer[40];
+    int pos = sizeof(buffer);
+    quint32 h = hi;
+    quint32 m = mid;
+    quint32 l = lo;
+    int count = 0;
+    while(h != 0 || m != 0 || l != 0 || count <= scale) {
+        quint64 r = h;
+        h = (quint32)(r / 10);
+        r = ((r % 10) << 32) | m;
+        m = (quint32)(r / 10);
+        r = ((r % 10) << 32) | l;
+        l = (quint32)(r / 10);
+        buffer[--pos] = '0' + (char)(r % 10);
+        count++;
+        if(count == scale) buffer[--pos] = '.';
+    }
+    if(negative) buffer[--pos] = '-';
+
+    return QString::fromLatin1(buffer + pos, sizeof(buffer) - pos);
 }
-void TPrimitiveByte::write(QTextStream& outstr){
-    outstr << value;
+
+// ==========================================
+// TDateTimeValue
+// ==========================================
+
+qint64 TDateTimeValue::toMSecsSinceEpoch() const {
+    // rounds down so dates before 1970 stay in order
+    qint64 t = ticks() - DATETIME_EPOCH_TICKS;
+    if(t < 0) t -= 9999;
+    return t / 10000;
 }
-void TPrimitiveByte::writeType(QTextStream& outstr){
-    outstr << " (byte) ";
+
+QDateTime TDateTimeValue::toDateTime() const {
+    QDateTime result = QDateTime::fromMSecsSinceEpoch(toMSecsSinceEpoch(), Qt::UTC);
+    // local ticks are the wall clock time, not an offset from utc
+    if(kind() == 2) result.setTimeSpec(Qt::LocalTime);
+    return result;
 }
 
-// --------- 3 ------------
-bool TPrimitiveChar::read(TBinaryInput& input){
-    char buffer[6];
-    memset(buffer, 0, 6);
+// the nanosecond conversions take two values at a time with SSE2
+// which has no 64 bit multiply, so x * 100 is (x << 6) + (x << 5) + (x << 2)
+// the millisecond ones divide by 10000 and neither SSE2 nor AVX2
+// has a 64 bit divide or multiply high, so they stay scalar
 
-    if(!input.readBytes(buffer, 1)) return false;
-    int count = 0;
-    if((buffer[0] & 0x80) == 0x00) count = 1;
-    else if((buffer[0] & 0xE0) == 0xC0) count = 2;
-    else if((buffer[0] & 0xF0) == 0xE0) count = 3;
-    else if((buffer[0] & 0xF0) == 0xF0) count = 4;
-    else return false;
+#ifdef __SSE2__
+static inline __m128i times100(__m128i v) {
+    return _mm_add_epi64(_mm_add_epi64(_mm_slli_epi64(v, 6), _mm_slli_epi64(v, 5)), _mm_slli_epi64(v, 2));
+}
+#endif
 
-    if(count > 1) {
-        if(!input.readBytes(&(buffer[1]), count - 1)) return false;
+void dateTimeToMSecs(const TDateTimeValue* values, qint64* result, int count) {
+    for(int i=0; i<count; i++) {
+        qint64 t = (qint64)(values[i].raw & Q_UINT64_C(0x3fffffffffffffff)) - DATETIME_EPOCH_TICKS;
+        result[i] = (t - (t < 0 ? 9999 : 0)) / 10000;
     }
-
-    value = QString::fromUtf8(buffer, count);
-    return true;
 }
-void TPrimitiveChar::write(QTextStream& outstr){
-    outstr << value;
+
+void dateTimeToNSecs(const TDateTimeValue* values, qint64* result, int count) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi64x(Q_INT64_C(0x3fffffffffffffff));
+    const __m128i epoch = _mm_set1_epi64x(DATETIME_EPOCH_TICKS);
+    for(; i + 2 <= count; i += 2) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(values + i));
+        v = _mm_sub_epi64(_mm_and_si128(v, mask), epoch);
+        _mm_storeu_si128((__m128i*)(result + i), times100(v));
+    }
+#endif
+    for(; i<count; i++) {
+        qint64 t = (qint64)(values[i].raw & Q_UINT64_C(0x3fffffffffffffff)) - DATETIME_EPOCH_TICKS;
+        result[i] = t * 100;
+    }
 }
-void TPrimitiveChar::writeType(QTextStream& outstr){
-    outstr << " (char) ";
+
+void timeSpanToMSecs(const TTimeSpanValue* values, qint64* result, int count) {
+    // TimeSpan.TotalMilliseconds truncates towards zero
+    for(int i=0; i<count; i++) {
+        result[i] = values[i].ticks / 10000;
+    }
 }
 
-// --------- 5 ------------
-bool TPrimitiveDecimal::read(TBinaryInput& input){
-    QString str;
-    if(!input.readString(str)) return false;
-    value = str.toDouble();
-    return true;
+void timeSpanToNSecs(const TTimeSpanValue* values, qint64* result, int count) {
+    int i = 0;
+#ifdef __SSE2__
+    for(; i + 2 <= count; i += 2) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(values + i));
+        _mm_storeu_si128((__m128i*)(result + i), times100(v));
+    }
+#endif
+    for(; i<count; i++) {
+        result[i] = values[i].ticks * 100;
+    }
 }
-void TPrimitiveDecimal::write(QTextStream& outstr){
-    outstr << value;
+
+// ==========================================
+// TValue
+// ==========================================
+
+TValue::TValue() {
+    type = 17;
+    u = 0;
 }
-void TPrimitiveDecimal::writeType(QTextStream& outstr){
-    outstr << " (decimal) ";
+
+TValue::~TValue() {
+    clear();
 }
 
-// --------- 6 ------------
-bool TPrimitiveDouble::read(TBinaryInput& input){
-    if(!input.readBytes((char*)&value, 8)) return false;
-    return true;
+void TValue::clear() {
+    if(type == 3 || type == 18) delete str;
+    else if(type == 5) delete decimal;
+    type = 17;
+    u = 0;
 }
-void TPrimitiveDouble::write(QTextStream& outstr){
-    outstr << value;
+
+bool TValue::isValidType(char code) {
+    // 4 is unused
+    return code >= 1 && code <= 18 && code != 4;
 }
-void TPrimitiveDouble::writeType(QTextStream& outstr){
-    outstr << " (double) ";
+
+int TValue::fixedSize(char code) {
+    // bytes of a value in file and in a column, 0 if not fixed
+    switch(code) {
+        case 1: case 2: case 10:
+            return 1;
+        case 7: case 14:
+            return 2;
+        case 8: case 11: case 15:
+            return 4;
+        case 6: case 9: case 12: case 13: case 16:
+            return 8;
+    }
+    return 0;
 }
 
-// --------- 7 ------------
-bool TPrimitiveInt16::read(TBinaryInput& input){
-    if(!input.readBytes((char*)&value, 2)) return false;
-    return true;
+bool TValue::readFixed(TBinaryInput& input, char code, char* data) {
+    // a fixed size value straight into data, in host byte order
+    switch(fixedSize(code)) {
+        case 1: {
+            if(!input.readChar(*data)) return false;
+            if(code == 1) *data = (*data != 0);
+            return true;
+        }
+        case 2: return input.readValue(*(quint16*)data);
+        case 4: return input.readValue(*(quint32*)data);
+        case 8: return input.readValue(*(quint64*)data);
+    }
+    return false;
 }
-void TPrimitiveInt16::write(QTextStream& outstr){
-    outstr << value;
+
+bool TValue::read(TBinaryInput& input, char code) {
+    if(type != code) {
+        clear();
+        if(!isValidType(code)) return false;
+        type = code;
+        if(type == 3 || type == 18) str = new QString();
+        else if(type == 5) decimal = new TDecimal();
+    }
+
+    switch(type) {
+        case 1: {
+            char c;
+            if(!input.readChar(c)) return false;
+            b = (c != 0);
+            return true;
+        }
+        case 2:
+        case 10: {
+            char c;
+            if(!input.readChar(c)) return false;
+            i = c;
+            return true;
+        }
+        case 3:
+            return input.readChars(*str, 1);
+        case 5:
+            return input.readDecimal(*decimal);
+        case 6:
+            return input.readDouble(d);
+        case 7: {
+            qint16 v;
+            if(!input.readValue(v)) return false;
+            i = v;
+            return true;
+        }
+        case 8: {
+            qint32 v;
+            if(!input.readI32(v)) return false;
+            i = v;
+            return true;
+        }
+        case 9:
+        case 12:
+            return input.readI64(i);
+        case 11:
+            return input.readValue(f);
+        case 13:
+            // DateTime kept as in file, converted when asked for
+            return input.readValue(u);
+        case 14: {
+            quint16 v;
+            if(!input.readValue(v)) return false;
+            u = v;
+            return true;
+        }
+        case 15: {
+            quint32 v;
+            if(!input.readValue(v)) return false;
+            u = v;
+            return true;
+        }
+        case 16:
+            return input.readValue(u);
+        case 17:
+            return true;
+        case 18:
+            return input.readString(*str);
+    }
+    return false;
 }
-void TPrimitiveInt16::writeType(QTextStream& outstr){
-    outstr << " (int16) ";
+
+void TValue::load(char code, const char* data) {
+    // from a fixed size value in host byte order
+    if(type != code) {
+        clear();
+        type = code;
+    }
+
+    switch(type) {
+        case 1: b = (*data != 0); break;
+        case 2:
+        case 10: i = *data; break;
+        case 7: i = *(const qint16*)data; break;
+        case 8: i = *(const qint32*)data; break;
+        case 11: memcpy(&f, data, sizeof(float)); break;
+        case 14: u = *(const quint16*)data; break;
+        case 15: u = *(const quint32*)data; break;
+        case 6: case 9: case 12: case 13: case 16:
+            memcpy(&u, data, sizeof(quint64));
+            break;
+    }
 }
 
-// --------- 8 ------------
-bool TPrimitiveInt32::read(TBinaryInput& input){
-    if(!input.readBytes((char*)&value, 4)) return false;
-    return true;
+void TValue::store(char* data) const {
+    // reverse of load
+    switch(type) {
+        case 1: *data = b ? 1 : 0; break;
+        case 2:
+        case 10: *data = (char)i; break;
+        case 7: *(qint16*)data = (qint16)i; break;
+        case 8: *(qint32*)data = (qint32)i; break;
+        case 11: memcpy(data, &f, sizeof(float)); break;
+        case 14: *(quint16*)data = (quint16)u; break;
+        case 15: *(quint32*)data = (quint32)u; break;
+        case 6: case 9: case 12: case 13: case 16:
+            memcpy(data, &u, sizeof(quint64));
+            break;
+    }
 }
-void TPrimitiveInt32::write(QTextStream& outstr){
-    outstr << value;
+
+void TValue::write(QTextStream& outstr) const {
+    switch(type) {
+        case 1: outstr << (b ? "true" : "false"); break;
+        case 2:
+        case 10: outstr << (char)i; break;
+        case 3:
+        case 18: outstr << *str; break;
+        case 5: outstr << decimal->toString(); break;
+        case 6: outstr << d; break;
+        case 7: outstr << (qint16)i; break;
+        case 8: outstr << (qint32)i; break;
+        case 9:
+        case 12: outstr << i; break;
+        case 11: outstr << f; break;
+        case 13: {
+            TDateTimeValue dt;
+            dt.raw = u;
+            outstr << dt.toDateTime().toString();
+            break;
+        }
+        case 14: outstr << (quint16)u; break;
+        case 15: outstr << (quint32)u; break;
+        case 16: outstr << u; break;
+        case 17: outstr << "null"; break;
+    }
 }
-void TPrimitiveInt32::writeType(QTextStream& outstr){
-    outstr << " (int32) ";
+
+qint64 TValue::heapSize() const {
+    if(type == 3 || type == 18) return sizeof(QString) + str->capacity() * sizeof(QChar);
+    if(type == 5) return sizeof(TDecimal);
+    return 0;
 }
 
-// --------- 9 ------------
-bool TPrimitiveInt64::read(TBinaryInput& input){
-    if(!input.readBytes((char*)&value, 8)) return false;
+void TValue::writeType(QTextStream& outstr) const {
+    switch(type) {
+        case 1: outstr << " (bool) "; break;
+        case 2: outstr << " (byte) "; break;
+        case 3: outstr << " (char) "; break;
+        case 5: outstr << " (decimal) "; break;
+        case 6: outstr << " (double) "; break;
+        case 7: outstr << " (int16) "; break;
+        case 8: outstr << " (int32) "; break;
+        case 9: outstr << " (int64) "; break;
+        case 10: outstr << " (sbyte) "; break;
+        case 11: outstr << " (single) "; break;
+        case 12: outstr << " (time) "; break;
+        case 13: outstr << " (timedate) "; break;
+        case 14: outstr << " (uint16) "; break;
+        case 15: outstr << " (uint32) "; break;
+        case 16: outstr << " (uint64) "; break;
+        case 17: outstr << " (null) "; break;
+        case 18: outstr << " (string) "; break;
+    }
+}
+
+bool TValue::getBool(bool& result) const {
+    if(type != 1) return false;
+    result = b;
     return true;
 }
-void TPrimitiveInt64::write(QTextStream& outstr){
-    outstr << value;
+
+bool TValue::getInt(qint64& result) const {
+    switch(type) {
+        case 2: case 7: case 8: case 9: case 10: case 12:
+            result = i;
+            return true;
+    }
+    return false;
 }
-void TPrimitiveInt64::writeType(QTextStream& outstr){
-    outstr << " (int64) ";
+
+bool TValue::getUnsigned(quint64& result) const {
+    switch(type) {
+        case 14: case 15: case 16:
+            result = u;
+            return true;
+    }
+    return false;
 }
 
-// --------- 10 ------------
-bool TPrimitiveSByte::read(TBinaryInput& input){
-    if(!input.readBytes(&value, 1)) return false;
+bool TValue::getDouble(double& result) const {
+    if(type == 6) {
+        result = d;
+        return true;
+    }
+    if(type == 5) {
+        result = decimal->toDouble();
+        return true;
+    }
+    return false;
+}
 
+bool TValue::getFloat(float& result) const {
+    if(type != 11) return false;
+    result = f;
     return true;
 }
-void TPrimitiveSByte::write(QTextStream& outstr){
-    outstr << value;
-}
-void TPrimitiveSByte::writeType(QTextStream& outstr){
-    outstr << " (sbyte) ";
+
+bool TValue::getString(QString& result) const {
+    if(type != 3 && type != 18) return false;
+    result = *str;
+    return true;
 }
 
-// --------- 11 ------------
-bool TPrimitiveSingle::read(TBinaryInput& input){
-    if(!input.readBytes((char*)&value, 4)) return false;
+bool TValue::getDateTime(QDateTime& result) const {
+    if(type != 13) return false;
+    TDateTimeValue dt;
+    dt.raw = u;
+    result = dt.toDateTime();
+    return true;
+}
+
+bool TValue::getDecimal(TDecimal& result) const {
+    if(type != 5) return false;
+    result = *decimal;
+    return true;
+}
+
+// ==========================================
+// TClassSchema
+// ==========================================
+
+TClassSchema::TClassSchema() {
+    columns = NULL;
+}
+
+TClassSchema::~TClassSchema() {
+    for(int i=0; i<types.count(); i++) {
+        delete types.at(i);
+    }
+    if(columns != NULL) delete columns;
+}
+
+bool TClassSchema::read(TBinaryInput& input, TClassInfo& info, TArena* arena) {
+    classInfo = info;
+
+    // read member types
+    for(int i=0; i<classInfo.memberCount(); i++) {
+        char type;
+        if(!input.readChar(type)) return false;
+
+        TBinaryType* binarytype = getBinaryType(type, arena);
+        if(binarytype == NULL) return false;
+
+        types.append(binarytype);
+    }
+
+    // read member additional info
+    for(int i=0; i<types.count(); i++) {
+        if(!types.at(i)->readAdditional(input)) return false;
+    }
+
+    // row 0 of the columns is the class record
+    columns = new TClassColumns(this);
+    if(columns->hasColumns()) {
+        columns->addRow();
+    }
+    else {
+        delete columns;
+        columns = NULL;
+    }
+
+    return true;
+}
+
+void TClassSchema::cloneTypes(QList<TBinaryType*>& list, TArena* arena) {
+    for(int i=0; i<types.count(); i++) {
+        list.append(types.at(i)->cloneType(arena));
+    }
+}
+
+qint64 TClassSchema::memorySize() {
+    // the rows of its objects are counted with each object
+    qint64 size = sizeof(TClassSchema);
+    size += classInfo.memberIDs.capacity() * sizeof(qint32);
+    size += types.count() * sizeof(void*);
+    for(int i=0; i<types.count(); i++) {
+        size += types.at(i)->memorySize();
+    }
+    if(columns != NULL) {
+        size += sizeof(TClassColumns);
+        size += columns->columns.capacity() * sizeof(TColumn);
+        size += columns->slots.capacity() * sizeof(int);
+    }
+    return size;
+}
+
+// ==========================================
+// TClassColumns
+// ==========================================
+
+TClassColumns::TClassColumns(TClassSchema* schema) {
+    classInfo = schema->classInfo;
+    rows = 0;
+    rowSize = 0;
+
+    int n = schema->types.count();
+    columns.resize(n);
+    slots.resize(n);
+
+    int slot = 0;
+    for(int i=0; i<n; i++) {
+        char code = schema->types.at(i)->primitiveType();
+        int size = TValue::fixedSize(code);
+        if(size > 0) {
+            columns[i].typeEnum = code;
+            columns[i].size = size;
+            slots[i] = -1;
+            rowSize += size;
+        }
+        else {
+            slots[i] = slot++;
+        }
+    }
+}
+
+bool TClassColumns::hasColumns() {
+    for(int i=0; i<columns.count(); i++) {
+        if(columns.at(i).size > 0) return true;
+    }
+    return false;
+}
+
+int TClassColumns::addRow() {
+    // rows are reserved before the object is read
+    // so objects nested in its members come after it
+    for(int i=0; i<columns.count(); i++) {
+        TColumn& c = columns[i];
+        if(c.size > 0) c.data.resize((rows + 1) * c.size);
+    }
+    return rows++;
+}
+
+bool TClassColumns::readValue(TBinaryInput& input, int member, int row) {
+    TColumn& c = columns[member];
+    return TValue::readFixed(input, c.typeEnum, c.data.data() + row * c.size);
+}
+
+void TClassColumns::storeRow(int row, TFileRecord* record) {
+    for(int i=0; i<columns.count(); i++) {
+        TColumn& c = columns[i];
+        if(c.size == 0) continue;
+        TBinaryPrimitive* b = (TBinaryPrimitive*)record->memberList.at(i);
+        b->value.store(c.data.data() + row * c.size);
+    }
+}
+
+void TClassColumns::getValue(int member, int row, TValue& value) {
+    const TColumn& c = columns.at(member);
+    value.load(c.typeEnum, c.data.constData() + row * c.size);
+}
+
+// ==========================================
+// TElementRuns
+// ==========================================
+
+qint32 TElementRuns::add(qint32 element) {
+    // elements are added in increasing order
+    if(!runs.isEmpty()) {
+        TRun& last = runs.last();
+        if(last.start + last.count == element) {
+            last.count++;
+            return slots++;
+        }
+    }
+
+    TRun run;
+    run.start = element;
+    run.count = 1;
+    run.slot = slots;
+    runs.append(run);
+    return slots++;
+}
+
+qint32 TElementRuns::find(qint32 element) const {
+    // slot of element, -1 if it is null
+    int lo = 0;
+    int hi = runs.count();
+    while(lo < hi) {
+        int mid = (lo + hi) / 2;
+        if(runs.at(mid).start <= element) lo = mid + 1;
+        else hi = mid;
+    }
+    if(lo == 0) return -1;
+
+    const TRun& run = runs.at(lo - 1);
+    if(element >= run.start + run.count) return -1;
+    return run.slot + element - run.start;
+}
+
+// ==========================================
+// PrimitiveTypeEnumeration
+// ==========================================
+
+// --------- 1 ------------
+bool TPrimitiveBoolean::read(TBinaryInput& input){
+    char c;
+    if(!input.readChar(c)) return false;
+    value = (c != 0);
+    return true;
+}
+void TPrimitiveBoolean::write(QTextStream& outstr){
+
+    if(value) {
+        outstr << "true";
+    }
+    else {
+        outstr << "false";
+    }
+}
+void TPrimitiveBoolean::writeType(QTextStream& outstr){
+    outstr << " (bool) ";
+}
+
+// --------- 2 ------------
+bool TPrimitiveByte::read(TBinaryInput& input){
+    if(!input.readChar(value)) return false;
+    return true;
+}
+void TPrimitiveByte::write(QTextStream& outstr){
+    outstr << value;
+}
+void TPrimitiveByte::writeType(QTextStream& outstr){
+    outstr << " (byte) ";
+}
+
+// --------- 3 ------------
+bool TPrimitiveChar::read(TBinaryInput& input){
+    return input.readChars(value, 1);
+}
+void TPrimitiveChar::write(QTextStream& outstr){
+    outstr << value;
+}
+void TPrimitiveChar::writeType(QTextStream& outstr){
+    outstr << " (char) ";
+}
+
+// --------- 5 ------------
+bool TPrimitiveDecimal::read(TBinaryInput& input){
+    return input.readDecimal(value);
+}
+void TPrimitiveDecimal::write(QTextStream& outstr){
+    outstr << value.toString();
+}
+void TPrimitiveDecimal::writeType(QTextStream& outstr){
+    outstr << " (decimal) ";
+}
+
+// --------- 6 ------------
+bool TPrimitiveDouble::read(TBinaryInput& input){
+    if(!input.readValue(value)) return false;
+    return true;
+}
+void TPrimitiveDouble::write(QTextStream& outstr){
+    outstr << value;
+}
+void TPrimitiveDouble::writeType(QTextStream& outstr){
+    outstr << " (double) ";
+}
+
+// --------- 7 ------------
+bool TPrimitiveInt16::read(TBinaryInput& input){
+    if(!input.readValue(value)) return false;
+    return true;
+}
+void TPrimitiveInt16::write(QTextStream& outstr){
+    outstr << value;
+}
+void TPrimitiveInt16::writeType(QTextStream& outstr){
+    outstr << " (int16) ";
+}
+
+// --------- 8 ------------
+bool TPrimitiveInt32::read(TBinaryInput& input){
+    if(!input.readValue(value)) return false;
+    return true;
+}
+void TPrimitiveInt32::write(QTextStream& outstr){
+    outstr << value;
+}
+void TPrimitiveInt32::writeType(QTextStream& outstr){
+    outstr << " (int32) ";
+}
+
+// --------- 9 ------------
+bool TPrimitiveInt64::read(TBinaryInput& input){
+    if(!input.readValue(value)) return false;
+    return true;
+}
+void TPrimitiveInt64::write(QTextStream& outstr){
+    outstr << value;
+}
+void TPrimitiveInt64::writeType(QTextStream& outstr){
+    outstr << " (int64) ";
+}
+
+// --------- 10 ------------
+bool TPrimitiveSByte::read(TBinaryInput& input){
+    if(!input.readChar(value)) return false;
+
+    return true;
+}
+void TPrimitiveSByte::write(QTextStream& outstr){
+    outstr << value;
+}
+void TPrimitiveSByte::writeType(QTextStream& outstr){
+    outstr << " (sbyte) ";
+}
+
+// --------- 11 ------------
+bool TPrimitiveSingle::read(TBinaryInput& input){
+    if(!input.readValue(value)) return false;
     return true;
 }
 void TPrimitiveSingle::write(QTextStream& outstr){
@@ -205,11 +1065,11 @@ void TPrimitiveSingle::writeType(QTextStream& outstr){
 
 // --------- 12 ------------
 bool TPrimitiveTimeSpan::read(TBinaryInput& input){
-    if(!input.readBytes((char*)&value, 8)) return false;
+    if(!input.readI64(value.ticks)) return false;
     return true;
 }
 void TPrimitiveTimeSpan::write(QTextStream& outstr){
-    outstr << value;
+    outstr << value.ticks;
 }
 void TPrimitiveTimeSpan::writeType(QTextStream& outstr){
     outstr << " (time) ";
@@ -217,20 +1077,12 @@ void TPrimitiveTimeSpan::writeType(QTextStream& outstr){
 
 // --------- 13 ------------
 bool TPrimitiveDateTime::read(TBinaryInput& input){
-
-    quint64 value;
-    if(!input.readBytes((char*)&value, 8)) return false;
-
-    // remove timezone
-    value = value & 0x3fffffffffffffff;
-    // change from 1/1/0000 to 1/1/1970
-    value = value - 0x089f7ff5f7b58000;
-    datetime = QDateTime::fromMSecsSinceEpoch(value/10000, Qt::UTC);
-
+    // kept as in file, converted when asked for
+    if(!input.readValue(value.raw)) return false;
     return true;
 }
 void TPrimitiveDateTime::write(QTextStream& outstr){
-    outstr << datetime.toString();
+    outstr << value.toDateTime().toString();
 }
 void TPrimitiveDateTime::writeType(QTextStream& outstr){
     outstr << " (timedate) ";
@@ -238,7 +1090,7 @@ void TPrimitiveDateTime::writeType(QTextStream& outstr){
 
 // --------- 14 ------------
 bool TPrimitiveUInt16::read(TBinaryInput& input){
-    if(!input.readBytes((char*)&value, 2)) return false;
+    if(!input.readValue(value)) return false;
     return true;
 }
 void TPrimitiveUInt16::write(QTextStream& outstr){
@@ -250,7 +1102,7 @@ void TPrimitiveUInt16::writeType(QTextStream& outstr){
 
 // --------- 15 ------------
 bool TPrimitiveUInt32::read(TBinaryInput& input){
-    if(!input.readBytes((char*)&value, 4)) return false;
+    if(!input.readValue(value)) return false;
     return true;
 }
 void TPrimitiveUInt32::write(QTextStream& outstr){
@@ -262,7 +1114,7 @@ void TPrimitiveUInt32::writeType(QTextStream& outstr){
 
 // --------- 16 ------------
 bool TPrimitiveUInt64::read(TBinaryInput& input){
-    if(!input.readBytes((char*)&value, 8)) return false;
+    if(!input.readValue(value)) return false;
     return true;
 }
 void TPrimitiveUInt64::write(QTextStream& outstr){
@@ -313,6 +1165,12 @@ TBinaryType* TBinaryType::getMember(int &index, QStringList &arglist)
     return NULL;
 }
 
+bool TBinaryType::getColumnMember(int& index, QStringList& arglist, TValue& value)
+{
+    if(refRecord != NULL) return refRecord->getColumnMember(index, arglist, value);
+    return false;
+}
+
 bool TBinaryType::getString(QString& str)
 {
     if(refRecord != NULL) return refRecord->getString(str);
@@ -355,6 +1213,12 @@ bool TBinaryType::getDateTime(QDateTime& result)
     return false;
 }
 
+bool TBinaryType::getDecimal(TDecimal& result)
+{
+    if(refRecord != NULL) return refRecord->getDecimal(result);
+    return false;
+}
+
 bool TBinaryType::getBoolArray(bool** array, int& len)
 {
     if(refRecord != NULL) return refRecord->getBoolArray(array, len);
@@ -373,6 +1237,24 @@ bool TBinaryType::getDoubleArray(double** array, int& len)
     return false;
 }
 
+bool TBinaryType::getDecimalArray(TDecimal** array, int& len)
+{
+    if(refRecord != NULL) return refRecord->getDecimalArray(array, len);
+    return false;
+}
+
+bool TBinaryType::getDateTimeArray(TDateTimeValue** array, int& len)
+{
+    if(refRecord != NULL) return refRecord->getDateTimeArray(array, len);
+    return false;
+}
+
+bool TBinaryType::getTimeSpanArray(TTimeSpanValue** array, int& len)
+{
+    if(refRecord != NULL) return refRecord->getTimeSpanArray(array, len);
+    return false;
+}
+
 bool TBinaryType::getStringArray(QStringList& array)
 {
     if(refRecord != NULL) return refRecord->getStringArray(array);
@@ -387,94 +1269,88 @@ bool TBinaryType::getObjectArray(TBinaryObject*** array, int& len)
 
 // --------- 0 ------------
 TBinaryPrimitive::TBinaryPrimitive() : TBinaryType() {
-    value = NULL;
-}
-
-TBinaryPrimitive::~TBinaryPrimitive() {
-    if(value != NULL) delete value;
+    typeEnum = 0;
 }
 
-bool TBinaryPrimitive::read(TBinaryInput& input, QList<TFileRecord*>&){
-    if(value != NULL) {
-        return(value->read((input)));
-    }
-    return false;
+bool TBinaryPrimitive::read(TBinaryInput& input, TRecordList&){
+    if(!value.read(input, typeEnum)) return false;
+    setPlain(value.heapSize() == 0);
+    return true;
 }
 
 bool TBinaryPrimitive::readAdditional(TBinaryInput& input){
-    if(!input.readBytes(&typeEnum, 1)) return false;
-    value = getPrimitiveType(typeEnum);
-    if(value == NULL) return false;
-    return true;
+    if(!input.readChar(typeEnum)) return false;
+    return TValue::isValidType(typeEnum);
 }
 
 void TBinaryPrimitive::write(QTextStream& outstr, int indent){
    if(indent > MAX_INDENT) {outstr << "..."; return;}
 
-   value->write(outstr);
+   value.write(outstr);
 }
 
 void TBinaryPrimitive::writeType(QTextStream& outstr){
-   value->writeType(outstr);
+   value.writeType(outstr);
 }
 
-TBinaryType* TBinaryPrimitive::cloneType() {
-    TBinaryPrimitive* b = new TBinaryPrimitive();
-    b->value = getPrimitiveType(typeEnum);
+TBinaryType* TBinaryPrimitive::cloneType(TArena* arena) {
+    TBinaryPrimitive* b = new(arena) TBinaryPrimitive();
+    b->typeEnum = typeEnum;
     return (TBinaryType*)b;
 }
 
 bool TBinaryPrimitive::getBool(bool& result)
 {
-    if(value == NULL) return false;
-    return value->getBool(result);
+    return value.getBool(result);
 }
 
 bool TBinaryPrimitive::getInt(qint64& result)
 {
-    if(value == NULL) return false;
-    return value->getInt(result);
+    return value.getInt(result);
 }
 
 bool TBinaryPrimitive::getUnsigned(quint64& result)
 {
-    if(value == NULL) return false;
-    return value->getUnsigned(result);
+    return value.getUnsigned(result);
 }
 
 bool TBinaryPrimitive::getDouble(double& result)
 {
-    if(value == NULL) return false;
-    return value->getDouble(result);
+    return value.getDouble(result);
 }
 
 bool TBinaryPrimitive::getFloat(float& result)
 {
-    if(value == NULL) return false;
-    return value->getFloat(result);
+    return value.getFloat(result);
 }
 
 bool TBinaryPrimitive::getString(QString& result)
 {
-    if(value == NULL) return false;
-    return value->getString(result);
+    return value.getString(result);
 }
 
 bool TBinaryPrimitive::getDateTime(QDateTime& result)
 {
-    if(value == NULL) return false;
-    return value->getDateTime(result);
+    return value.getDateTime(result);
+}
+
+bool TBinaryPrimitive::getDecimal(TDecimal& result)
+{
+    return value.getDecimal(result);
 }
 
 // --------- 1 ------------
 TBinaryString::TBinaryString() : TBinaryType() {
 }
 
-bool TBinaryString::read(TBinaryInput& input, QList<TFileRecord*>& list){
+bool TBinaryString::read(TBinaryInput& input, TRecordList& list){
+    // the string itself is a record of the list, value stays empty
+    setPlain(value.isNull());
+
     char ref;
-    if(!input.readBytes(&ref, 1)) return false;
+    if(!input.readChar(ref)) return false;
     if(ref == 6) {
-        TBinaryObjectString* bos = new TBinaryObjectString();
+        TBinaryObjectString* bos = new(&list.arena) TBinaryObjectString();
         bos->type = 6;
         list.append(bos);
         if(!bos->read(input, list)) return false;
@@ -482,7 +1358,7 @@ bool TBinaryString::read(TBinaryInput& input, QList<TFileRecord*>& list){
         return true;
     }
     if(ref == 9) {
-        if(!input.readBytes((char*)&refID, 4)) return false;
+        if(!input.readI32(refID)) return false;
         return true;
     }
     if(ref == 0x0a) {
@@ -492,9 +1368,11 @@ bool TBinaryString::read(TBinaryInput& input, QList<TFileRecord*>& list){
     return false;
 }
 
-bool TBinaryString::readNoRef(char ref, TBinaryInput& input, QList<TFileRecord*>& list){
+bool TBinaryString::readNoRef(char ref, TBinaryInput& input, TRecordList& list){
+    setPlain(value.isNull());
+
     if(ref == 6) {
-        TBinaryObjectString* bos = new TBinaryObjectString();
+        TBinaryObjectString* bos = new(&list.arena) TBinaryObjectString();
         bos->type = 6;
         list.append(bos);
         if(!bos->read(input, list)) return false;
@@ -502,7 +1380,7 @@ bool TBinaryString::readNoRef(char ref, TBinaryInput& input, QList<TFileRecord*>
         return true;
     }
     if(ref == 9) {
-        if(!input.readBytes((char*)&refID, 4)) return false;
+        if(!input.readI32(refID)) return false;
         return true;
     }
     if(ref == 0x0a) {
@@ -528,8 +1406,8 @@ void TBinaryString::writeType(QTextStream& outstr){
     outstr << " (binary string) ";
 }
 
-TBinaryType* TBinaryString::cloneType() {
-    TBinaryString* b = new TBinaryString();
+TBinaryType* TBinaryString::cloneType(TArena* arena) {
+    TBinaryString* b = new(arena) TBinaryString();
     return (TBinaryType*)b;
 }
 
@@ -547,18 +1425,20 @@ bool TBinaryString::getString(QString& result)
 TBinaryObject::TBinaryObject() : TBinaryType() {
 }
 
-bool TBinaryObject::read(TBinaryInput& input, QList<TFileRecord*>& recordList){
+bool TBinaryObject::read(TBinaryInput& input, TRecordList& recordList){
+    setPlain(true);
+
     char ref;
-    if(!input.readBytes(&ref, 1)) return false;
+    if(!input.readChar(ref)) return false;
 
     if(ref == 16) return false;
 
     if(ref == 9) {
-        if(!input.readBytes((char*)&refID, 4)) return false;
+        if(!input.readI32(refID)) return false;
         return true;
     }
 
-    refRecord = getRecordType(ref);
+    refRecord = getRecordType(ref, &recordList.arena);
     if(refRecord == NULL) return false;
     refRecord->isReferenced = true;
     recordList.append(refRecord);
@@ -568,16 +1448,18 @@ bool TBinaryObject::read(TBinaryInput& input, QList<TFileRecord*>& recordList){
     return true;
 }
 
-bool TBinaryObject::readNoRef(char ref, TBinaryInput& input, QList<TFileRecord*>& recordList){
+bool TBinaryObject::readNoRef(char ref, TBinaryInput& input, TRecordList& recordList){
+    // the record it refers to belongs to the record list
+    setPlain(true);
 
     if(ref == 16) return false;
 
     if(ref == 9) {
-        if(!input.readBytes((char*)&refID, 4)) return false;
+        if(!input.readI32(refID)) return false;
         return true;
     }
 
-    refRecord = getRecordType(ref);
+    refRecord = getRecordType(ref, &recordList.arena);
     if(refRecord == NULL) return false;
     refRecord->isReferenced = true;
     recordList.append(refRecord);
@@ -605,8 +1487,8 @@ void TBinaryObject::writeType(QTextStream& outstr){
     outstr << " (object) ";
 }
 
-TBinaryType* TBinaryObject::cloneType() {
-    TBinaryObject* b = new TBinaryObject();
+TBinaryType* TBinaryObject::cloneType(TArena* arena) {
+    TBinaryObject* b = new(arena) TBinaryObject();
     return (TBinaryType*)b;
 }
 
@@ -614,16 +1496,16 @@ TBinaryType* TBinaryObject::cloneType() {
 TBinarySystemClass::TBinarySystemClass() : TBinaryType() {
 }
 
-bool TBinarySystemClass::read(TBinaryInput& input, QList<TFileRecord*>& recordList){
+bool TBinarySystemClass::read(TBinaryInput& input, TRecordList& recordList){
     char ref;
-    if(!input.readBytes(&ref, 1)) return false;
+    if(!input.readChar(ref)) return false;
 
     if(ref == 9) {
-        if(!input.readBytes((char*)&refID, 4)) return false;
+        if(!input.readI32(refID)) return false;
         return true;
     }
 
-    refRecord = getRecordType(ref);
+    refRecord = getRecordType(ref, &recordList.arena);
     if(refRecord == NULL) return false;
     refRecord->isReferenced = true;
     recordList.append(refRecord);
@@ -656,8 +1538,8 @@ void TBinarySystemClass::writeType(QTextStream& outstr){
     outstr << " (systemclass) ";
 }
 
-TBinaryType* TBinarySystemClass::cloneType() {
-    TBinarySystemClass* b = new TBinarySystemClass();
+TBinaryType* TBinarySystemClass::cloneType(TArena* arena) {
+    TBinarySystemClass* b = new(arena) TBinarySystemClass();
     return (TBinaryType*)b;
 }
 
@@ -665,16 +1547,16 @@ TBinaryType* TBinarySystemClass::cloneType() {
 TBinaryClass::TBinaryClass() : TBinaryType() {
 }
 
-bool TBinaryClass::read(TBinaryInput& input, QList<TFileRecord*>& recordList){
+bool TBinaryClass::read(TBinaryInput& input, TRecordList& recordList){
     char ref;
-    if(!input.readBytes(&ref, 1)) return false;
+    if(!input.readChar(ref)) return false;
 
     if(ref == 9) {
-        if(!input.readBytes((char*)&refID, 4)) return false;
+        if(!input.readI32(refID)) return false;
         return true;
     }
 
-    refRecord = getRecordType(ref);
+    refRecord = getRecordType(ref, &recordList.arena);
     if(refRecord == NULL) return false;
     refRecord->isReferenced = true;
     recordList.append(refRecord);
@@ -686,7 +1568,7 @@ bool TBinaryClass::read(TBinaryInput& input, QList<TFileRecord*>& recordList){
 
 bool TBinaryClass::readAdditional(TBinaryInput& input){
     if(!input.readString(name)) return false;
-    if(!input.readBytes((char*)&libraryID, 4)) return false;
+    if(!input.readI32(libraryID)) return false;
     return true;
 }
 
@@ -708,8 +1590,8 @@ void TBinaryClass::writeType(QTextStream& outstr){
     outstr << " (class) ";
 }
 
-TBinaryType* TBinaryClass::cloneType() {
-    TBinaryClass* b = new TBinaryClass();
+TBinaryType* TBinaryClass::cloneType(TArena* arena) {
+    TBinaryClass* b = new(arena) TBinaryClass();
     return (TBinaryType*)b;
 }
 
@@ -717,12 +1599,12 @@ TBinaryType* TBinaryClass::cloneType() {
 TBinaryObjectArray::TBinaryObjectArray() : TBinaryType() {
 }
 
-bool TBinaryObjectArray::read(TBinaryInput& input, QList<TFileRecord*>&){
+bool TBinaryObjectArray::read(TBinaryInput& input, TRecordList&){
     char ref;
-    if(!input.readBytes(&ref, 1)) return false;
+    if(!input.readChar(ref)) return false;
 
     if(ref == 9) {
-        if(!input.readBytes((char*)&refID, 4)) return false;
+        if(!input.readI32(refID)) return false;
         return true;
     }
     if(ref == 10) {
@@ -752,8 +1634,8 @@ void TBinaryObjectArray::writeType(QTextStream& outstr){
     outstr << " (objectarray) ";
 }
 
-TBinaryType* TBinaryObjectArray::cloneType() {
-    TBinaryObjectArray* b = new TBinaryObjectArray();
+TBinaryType* TBinaryObjectArray::cloneType(TArena* arena) {
+    TBinaryObjectArray* b = new(arena) TBinaryObjectArray();
     return (TBinaryType*)b;
 }
 
@@ -761,12 +1643,12 @@ TBinaryType* TBinaryObjectArray::cloneType() {
 TBinaryStringArray::TBinaryStringArray() : TBinaryType() {
 }
 
-bool TBinaryStringArray::read(TBinaryInput& input, QList<TFileRecord*>&){
+bool TBinaryStringArray::read(TBinaryInput& input, TRecordList&){
     char ref;
-    if(!input.readBytes(&ref, 1)) return false;
+    if(!input.readChar(ref)) return false;
 
     if(ref == 9) {
-        if(!input.readBytes((char*)&refID, 4)) return false;
+        if(!input.readI32(refID)) return false;
         return true;
     }
     if(ref == 10) {
@@ -796,8 +1678,8 @@ void TBinaryStringArray::writeType(QTextStream& outstr){
     outstr << " (stringarray) ";
 }
 
-TBinaryType* TBinaryStringArray::cloneType() {
-    TBinaryStringArray* b = new TBinaryStringArray();
+TBinaryType* TBinaryStringArray::cloneType(TArena* arena) {
+    TBinaryStringArray* b = new(arena) TBinaryStringArray();
     return (TBinaryType*)b;
 }
 
@@ -808,12 +1690,12 @@ TBinaryPrimitiveArray::TBinaryPrimitiveArray() : TBinaryType() {
 TBinaryPrimitiveArray::~TBinaryPrimitiveArray() {
 }
 
-bool TBinaryPrimitiveArray::read(TBinaryInput& input, QList<TFileRecord*>&){
+bool TBinaryPrimitiveArray::read(TBinaryInput& input, TRecordList&){
     char ref;
-    if(!input.readBytes(&ref, 1)) return false;
+    if(!input.readChar(ref)) return false;
 
     if(ref == 9) {
-        if(!input.readBytes((char*)&refID, 4)) return false;
+        if(!input.readI32(refID)) return false;
         return true;
     }
     if(ref == 10) {
@@ -826,7 +1708,7 @@ bool TBinaryPrimitiveArray::read(TBinaryInput& input, QList<TFileRecord*>&){
 }
 
 bool TBinaryPrimitiveArray::readAdditional(TBinaryInput& input){
-    if(!input.readBytes(&typeEnum, 1)) return false;
+    if(!input.readChar(typeEnum)) return false;
     return true;
 }
 
@@ -845,8 +1727,8 @@ void TBinaryPrimitiveArray::writeType(QTextStream& outstr){
     outstr << " (primitivearray) ";
 }
 
-TBinaryType* TBinaryPrimitiveArray::cloneType() {
-    TBinaryPrimitiveArray* b = new TBinaryPrimitiveArray();
+TBinaryType* TBinaryPrimitiveArray::cloneType(TArena* arena) {
+    TBinaryPrimitiveArray* b = new(arena) TBinaryPrimitiveArray();
     return (TBinaryType*)b;
 }
 
@@ -863,7 +1745,7 @@ TFileRecord::TFileRecord() {
 
 TFileRecord::~TFileRecord() {
     for(int i=0; i<memberList.count(); i++) {
-        delete memberList.at(i);
+        destroy(memberList.at(i));
     }
 }
 
@@ -877,6 +1759,15 @@ void TFileRecord::getReferences(QList<TBinaryType*>& list) {
     }
 }
 
+qint64 TFileRecord::memorySize() {
+    // records nested in members count for themselves
+    qint64 size = nodeSize(this) + memberList.count() * sizeof(void*);
+    for(int i=0; i<memberList.count(); i++) {
+        size += memberList.at(i)->memorySize();
+    }
+    return size;
+}
+
 TBinaryType* TFileRecord::getMember(int &index, QStringList &arglist)
 {
     QString str = arglist.at(index);
@@ -889,12 +1780,9 @@ TBinaryType* TFileRecord::getMember(int &index, QStringList &arglist)
     }
     else {
         // member name
-        for(int i=0; i<classInfo.memberNames.length(); i++) {
-            if(classInfo.memberNames.at(i) == str) {
-                if(i < memberList.length()) {
-                    return memberList.at(i);
-                }
-            }
+        int i = classInfo.memberIndex(str);
+        if(i >= 0 && i < memberList.length()) {
+            return memberList.at(i);
         }
     }
     return NULL;
@@ -905,13 +1793,12 @@ TSerializedStreamHeader::TSerializedStreamHeader() : TFileRecord() {
 
 }
 
-bool TSerializedStreamHeader::read(TBinaryInput& input, QList<TFileRecord*>&) {
-    if(!input.readBytes((char*)&rootID, 4)) return false;
-    if(!input.readBytes((char*)&headerID, 4)) return false;
-    if(!input.readBytes((char*)&majorVersion, 4)) return false;
-    if(!input.readBytes((char*)&minorVersion, 4)) return false;
-    classInfo.displayName = "Header";
-    classInfo.name = "Header";
+bool TSerializedStreamHeader::read(TBinaryInput& input, TRecordList& recordList) {
+    if(!input.readI32(rootID)) return false;
+    if(!input.readI32(headerID)) return false;
+    if(!input.readI32(majorVersion)) return false;
+    if(!input.readI32(minorVersion)) return false;
+    classInfo.setName(recordList.names, "Header");
     return true;
 }
 
@@ -925,63 +1812,142 @@ void TSerializedStreamHeader::write(QTextStream& outstr, int)
 // class members are defined in object referenced by metadataID
 
 TClassWithId::TClassWithId() : TFileRecord() {
-    metadataRecord = NULL;
+    schema = NULL;
+    columns = NULL;
+    row = 0;
 }
 
-bool TClassWithId::read(TBinaryInput& input, QList<TFileRecord*>& recordList) {
-    if(!input.readBytes((char*)&objectID, 4)) return false;
-    if(!input.readBytes((char*)&metadataID, 4)) return false;
-    classInfo.displayName = "ClassWithId";
-    classInfo.name = "ClassWithId";
+bool TClassWithId::read(TBinaryInput& input, TRecordList& recordList) {
+    if(!input.readI32(objectID)) return false;
+    if(!input.readI32(metadataID)) return false;
+    classInfo.setName(recordList.names, "ClassWithId");
+
+    // get schema containing member info
+    schema = recordList.schemas.value(metadataID, NULL);
+    if(schema == NULL) {
+        // metadataID may be another ClassWithId
+        TFileRecord* record = recordList.find(metadataID);
+        if(record == NULL || record->type != 1) return false;
+        schema = ((TClassWithId*)record)->schema;
+        if(schema == NULL) return false;
+    }
+
+    // share the member names with the schema
+    classInfo.memberIDs = schema->classInfo.memberIDs;
+
+    columns = schema->columns;
+    if(columns != NULL) row = columns->addRow();
 
-    // get record containing member info
-    metadataRecord = getRecord(metadataID, recordList);
-    if(metadataRecord == NULL) return false;
+    for(int i=0; i<schema->types.count(); i++) {
+        if(columns != NULL && columns->isColumn(i)) {
+            if(!columns->readValue(input, i, row)) return false;
+            continue;
+        }
 
-    for(int i=0; i<metadataRecord->memberList.length(); i++) {
-        TBinaryType* m = metadataRecord->memberList.at(i)->cloneType();
+        TBinaryType* m = schema->types.at(i)->cloneType(&recordList.arena);
         memberList.append(m);
         if(!m->read(input, recordList)) return false;
-
-        // copy names to this classinfo
-        classInfo.memberNames.append(metadataRecord->classInfo.memberNames.at(i));
     }
 
     return true;
 }
 
+TBinaryType* TClassWithId::memberAt(int i)
+{
+    // NULL past the members read and for members kept in columns
+    if(columns != NULL) {
+        if(columns->isColumn(i)) return NULL;
+        i = columns->slots.at(i);
+    }
+    if(i >= memberList.length()) return NULL;
+    return memberList.at(i);
+}
+
 void TClassWithId::write(QTextStream& outstr, int indent)
 {
     if(indent > MAX_INDENT) {outstr << "..."; return;}
 
-    if(metadataRecord == NULL) {
+    if(schema == NULL) {
         outstr << "ClassWithId (id " << objectID << " metadataID " << metadataID << ") ";
-    }
-    else {
-        outstr << metadataRecord->classInfo.displayName << " (id " << objectID << " metadataID " << metadataID << ") ClassWithId";
+        return;
     }
 
-    for(int i=0; i<memberList.length(); i++) {
+    outstr << schema->classInfo.displayName() << " (id " << objectID << " metadataID " << metadataID << ") ClassWithId";
+
+    for(int i=0; i<classInfo.memberCount(); i++) {
         outstr << "\n";
         indentOutput(outstr, indent + 1);
         outstr << "[" << i << "] ";
-        outstr << metadataRecord->classInfo.memberNames.at(i);
-        memberList.at(i)->writeType(outstr);
-        memberList.at(i)->write(outstr, indent);
-    }
-}
-
-// --------- 2 ------------
-TSystemClassWithMembers::TSystemClassWithMembers() : TFileRecord() {
+        outstr << schema->classInfo.memberName(i);
 
+        if(columns != NULL && columns->isColumn(i)) {
+            TValue value;
+            columns->getValue(i, row, value);
+            value.writeType(outstr);
+            value.write(outstr);
+        }
+        else {
+            TBinaryType* b = memberAt(i);
+            if(b == NULL) break;
+            b->writeType(outstr);
+            b->write(outstr, indent);
+        }
+    }
 }
 
-bool TSystemClassWithMembers::read(TBinaryInput& input, QList<TFileRecord*>&) {
-    if(!classInfo.read(input)) return false;
-    objectID = classInfo.objectID;
-
-    // not implemented -------
-    // type of the members is unknown
+int TClassWithId::memberIndex(int& index, QStringList& arglist)
+{
+    QString str = arglist.at(index);
+    int i;
+    if(str.at(0).isDigit()) {
+        // index number
+        bool ok;
+        i = str.toInt(&ok, 10);
+        if(!ok) return -1;
+    }
+    else {
+        // member name
+        i = classInfo.memberIndex(str);
+    }
+
+    if(i < 0 || i >= classInfo.memberCount()) return -1;
+    return i;
+}
+
+TBinaryType* TClassWithId::getMember(int& index, QStringList& arglist)
+{
+    int i = memberIndex(index, arglist);
+    if(i < 0) return NULL;
+    return memberAt(i);
+}
+
+bool TClassWithId::getColumnMember(int& index, QStringList& arglist, TValue& value)
+{
+    if(columns == NULL) return false;
+    int i = memberIndex(index, arglist);
+    if(i < 0 || !columns->isColumn(i)) return false;
+    columns->getValue(i, row, value);
+    return true;
+}
+
+qint64 TClassWithId::memorySize() {
+    // names are shared with the schema, the row is in its columns
+    qint64 size = TFileRecord::memorySize();
+    if(columns != NULL) size += columns->rowSize;
+    return size;
+}
+
+// --------- 2 ------------
+TSystemClassWithMembers::TSystemClassWithMembers() : TFileRecord() {
+
+}
+
+bool TSystemClassWithMembers::read(TBinaryInput& input, TRecordList& recordList) {
+    if(!classInfo.read(input, recordList.names)) return false;
+    objectID = classInfo.objectID;
+
+    // not implemented -------
+    // type of the members is unknown
     // because it should be supplied by the system
 
     return false;
@@ -999,11 +1965,11 @@ TClassWithMembers::TClassWithMembers() : TFileRecord() {
 
 }
 
-bool TClassWithMembers::read(TBinaryInput& input, QList<TFileRecord*>&) {
-    if(!classInfo.read(input)) return false;
+bool TClassWithMembers::read(TBinaryInput& input, TRecordList& recordList) {
+    if(!classInfo.read(input, recordList.names)) return false;
     objectID = classInfo.objectID;
 
-    if(!input.readBytes((char*)&libraryID, 4)) return false;
+    if(!input.readI32(libraryID)) return false;
 
     // reading of members
     // not implemented
@@ -1020,140 +1986,152 @@ void TClassWithMembers::write(QTextStream& outstr, int indent) {
 
 // --------- 4 ------------
 TSystemClassWithMembersAndTypes::TSystemClassWithMembersAndTypes() : TFileRecord() {
-
+    schema = NULL;
 }
 
-bool TSystemClassWithMembersAndTypes::read(TBinaryInput& input, QList<TFileRecord*>& recordList) {
+bool TSystemClassWithMembersAndTypes::read(TBinaryInput& input, TRecordList& recordList) {
 
     // read class info
-    if(!classInfo.read(input)) return false;
+    if(!classInfo.read(input, recordList.names)) return false;
     objectID = classInfo.objectID;
 
-    // read member types
-    for(int i=0; i<classInfo.memberNames.length(); i++) {
-        char type;
-        if(!input.readBytes(&type, 1)) return false;
-
-        TBinaryType* binarytype = getBinaryType(type);
-        if(binarytype == NULL) return false;
-
-        memberList.append(binarytype);
-    }
+    // member types and additional info, shared with ClassWithId records
+    schema = addSchema(this, input, recordList);
+    if(schema == NULL) return false;
 
-    // read member additional info
-    for(int i=0; i<memberList.count(); i++) {
-        if(!memberList.at(i)->readAdditional(input)) return false;
-    }
+    // members of this record hold its own values
+    schema->cloneTypes(memberList, &recordList.arena);
 
     // read member data
     for(int i=0; i<memberList.count(); i++) {
         if(!memberList.at(i)->read(input, recordList)) return false;
     }
 
+    if(schema->columns != NULL) schema->columns->storeRow(0, this);
+
     return true;
 }
 
 void TSystemClassWithMembersAndTypes::write(QTextStream& outstr, int indent) {
     if(indent > MAX_INDENT) {outstr << "..."; return;}
 
-    outstr << classInfo.displayName;
+    outstr << classInfo.displayName();
     outstr << " (id " << objectID << ") SystemClassWithMembersAndTypes";
 
-    for(int i=0; i<classInfo.memberNames.length(); i++) {
+    for(int i=0; i<classInfo.memberCount(); i++) {
         outstr << "\n";
         indentOutput(outstr, indent + 1);
         outstr << "[" << i << "] ";
-        outstr << classInfo.memberNames.at(i);
+        outstr << classInfo.memberName(i);
         memberList.at(i)->writeType(outstr);
         memberList.at(i)->write(outstr, indent+1);
     }
 }
 
+qint64 TSystemClassWithMembersAndTypes::memorySize() {
+    // the schema is counted with the record that defines it
+    qint64 size = TFileRecord::memorySize();
+    if(schema != NULL) {
+        size += schema->memorySize();
+        if(schema->columns != NULL) size += schema->columns->rowSize;
+    }
+    return size;
+}
+
 // --------- 5 ------------
 TClassWithMembersAndTypes::TClassWithMembersAndTypes() : TFileRecord() {
+    schema = NULL;
 }
 
 TClassWithMembersAndTypes::~TClassWithMembersAndTypes(){
 }
 
-bool TClassWithMembersAndTypes::read(TBinaryInput& input, QList<TFileRecord*>& recordList) {
+bool TClassWithMembersAndTypes::read(TBinaryInput& input, TRecordList& recordList) {
 
     // read class info
-    if(!classInfo.read(input)) return false;
+    if(!classInfo.read(input, recordList.names)) return false;
     objectID = classInfo.objectID;
 
-    // read member types
-    for(int i=0; i<classInfo.memberNames.length(); i++) {
-        char type;
-        if(!input.readBytes(&type, 1)) return false;
-
-        TBinaryType* binarytype = getBinaryType(type);
-        if(binarytype == NULL) return false;
-
-        memberList.append(binarytype);
-    }
-
-    // read member additional info
-    for(int i=0; i<memberList.count(); i++) {
-        if(!memberList.at(i)->readAdditional(input)) return false;
-    }
+    // member types and additional info, shared with ClassWithId records
+    schema = addSchema(this, input, recordList);
+    if(schema == NULL) return false;
 
     // read libraryID
-    if(!input.readBytes((char*)&libraryID, 4)) return false;
+    if(!input.readI32(libraryID)) return false;
+
+    // members of this record hold its own values
+    schema->cloneTypes(memberList, &recordList.arena);
 
     // read member data
     for(int i=0; i<memberList.count(); i++) {
         if(!memberList.at(i)->read(input, recordList)) return false;
     }
 
+    if(schema->columns != NULL) schema->columns->storeRow(0, this);
+
     return true;
 }
 
 void TClassWithMembersAndTypes::write(QTextStream& outstr, int indent) {
     if(indent > MAX_INDENT) {outstr << "..."; return;}
 
-    outstr << classInfo.displayName;
+    outstr << classInfo.displayName();
     outstr << " (id " << objectID << ") ClassWithMembersAndTypes";
 
-    for(int i=0; i<classInfo.memberNames.length(); i++) {
+    for(int i=0; i<classInfo.memberCount(); i++) {
         outstr << "\n";
         indentOutput(outstr, indent + 1);
         outstr << "[" << i << "] ";
-        outstr << classInfo.memberNames.at(i);
+        outstr << classInfo.memberName(i);
         memberList.at(i)->writeType(outstr);
         memberList.at(i)->write(outstr, indent + 1);
     }
 }
 
+qint64 TClassWithMembersAndTypes::memorySize() {
+    // the schema is counted with the record that defines it
+    qint64 size = TFileRecord::memorySize();
+    if(schema != NULL) {
+        size += schema->memorySize();
+        if(schema->columns != NULL) size += schema->columns->rowSize;
+    }
+    return size;
+}
+
 // --------- 6 ------------
 TBinaryObjectString::TBinaryObjectString() : TFileRecord() {
 }
 
-bool TBinaryObjectString::read(TBinaryInput& input, QList<TFileRecord*>&) {
-    if(!input.readBytes((char*)&objectID, 4)) return false;
-    if(!input.readString(value)) return false;
-    classInfo.displayName = "ObjectString";
-    classInfo.name = "ObjectString";
+bool TBinaryObjectString::read(TBinaryInput& input, TRecordList& recordList) {
+    if(!input.readI32(objectID)) return false;
+    if(!input.readUtf8(utf8)) return false;
+    classInfo.setName(recordList.names, "ObjectString");
     return true;
 }
 
 void TBinaryObjectString::write(QTextStream& outstr, int)
 {
+    QString str;
+    getString(str);
     outstr << "ObjectString (id" << objectID << ") value:";
-    outstr << value;
+    outstr << str;
 }
 
 bool TBinaryObjectString::getString(QString& str) {
-    str = value;
+    decodeString(utf8.constData(), utf8.size(), str);
     return true;
 }
 
+qint64 TBinaryObjectString::memorySize() {
+    // nothing extra for a view into the input
+    return TFileRecord::memorySize() + utf8.capacity();
+}
+
 // --------- 7 ------------
 TBinaryArray::TBinaryArray() : TFileRecord() {
     lengths = NULL;
     lowerBounds = NULL;
     remoteType = NULL;
-    array = NULL;
     rank = 0;
     arraySize = 0;
     offset = NULL;
@@ -1161,11 +2139,8 @@ TBinaryArray::TBinaryArray() : TFileRecord() {
 
 TBinaryArray::~TBinaryArray() {
 
-    if(array != NULL) {
-        for(int i=0; i<arraySize; i++) {
-            if(array[i] != NULL) delete array[i];
-        }
-        delete[] array;
+    for(int i=0; i<objects.count(); i++) {
+        destroy(objects.at(i));
     }
 
     if(lengths != NULL) delete[] lengths;
@@ -1175,34 +2150,38 @@ TBinaryArray::~TBinaryArray() {
 }
 
 
-bool TBinaryArray::read(TBinaryInput& input, QList<TFileRecord*>& recordList)
+bool TBinaryArray::read(TBinaryInput& input, TRecordList& recordList)
 {
-    if(!input.readBytes((char*)&objectID, 4)) return false;
-    if(!input.readBytes(&arrayType, 1)) return false;
-    if(!input.readBytes((char*)&rank, 4)) return false;
-    classInfo.displayName = "Array";
-    classInfo.name = "Array";
+    if(!input.readI32(objectID)) return false;
+    if(!input.readChar(arrayType)) return false;
+    if(!input.readI32(rank)) return false;
+    classInfo.setName(recordList.names, "Array");
+
+    if(rank < 0) {
+        rank = 0;
+        return false;
+    }
 
     lengths = new qint32[rank];
     lowerBounds = new qint32[rank];
     offset = new int[rank];
 
     for(int i=0; i<rank; i++) {
-        if(!input.readBytes((char*)&(lengths[i]), 4)) return false;
+        if(!input.readI32(lengths[i])) return false;
     }
 
     if(arrayType == ARRAY_SINGLEOFFSET || arrayType == ARRAY_JAGGEDOFFSET || arrayType == ARRAY_RECTANGULAROFFSET) {
         // only present for SingleOffset, JaggedOffset, or RectangularOffset
         for(int i=0; i<rank; i++) {
-            if(!input.readBytes((char*)&(lowerBounds[i]), 4)) return false;
+            if(!input.readI32(lowerBounds[i])) return false;
         }
     }
 
     char type;
-    if(!input.readBytes(&type, 1)) return false;
+    if(!input.readChar(type)) return false;
 
     // single copy to read additional data
-    remoteType = getBinaryType(type);
+    remoteType = getBinaryType(type, &recordList.arena);
     if(remoteType == NULL) return false;
 
     if(!remoteType->readAdditional(input)) return false;
@@ -1213,55 +2192,58 @@ bool TBinaryArray::read(TBinaryInput& input, QList<TFileRecord*>& recordList)
         return true;
     }
 
-    arraySize = 1;
+    qint64 size = 1;
     for(int r=0; r<rank; r++) {
-        arraySize *= lengths[r];
+        if(lengths[r] < 0) return false;
+        size *= lengths[r];
+        if(size > INT_MAX) return false;
+
         offset[r] = 1;
         for(int s=r+1; s<rank; s++) {
             offset[r] *= lengths[s];
         }
     }
-    array = new TBinaryObject*[arraySize];
-
-    int nullcount = 0;
+    arraySize = (int)size;
 
     for(int i=0; i<arraySize; i++) {
+        if(!input.readChar(type)) return false;
 
-        if(nullcount > 0) {
-            nullcount--;
-            array[i] = NULL;
+        if(type == 10) {
+            // ObjectNull
         }
-        else {
-            if(!input.readBytes(&type, 1)) return false;
-
-            if(type == 10) {
-                // ObjectNull
-                array[i] = NULL;
-            }
-            else if(type == 14) {
-                // ObjectNullMultiple
-                qint32 n;
-                if(!input.readBytes((char*)&n, 4)) return false;
-                nullcount = n - 1;
-                array[i] = NULL;
-            }
-            else if(type == 13) {
-                // ObjectNullMultiple256
-                unsigned char n;
-                if(!input.readBytes((char*)&n, 1)) return false;
-                nullcount = n - 1;
-                array[i] = NULL;
-            }
-            else {
-                array[i] = new TBinaryObject();
-                if(!array[i]->readNoRef(type, input, recordList)) return false;
+        else if(type == 13 || type == 14) {
+            // ObjectNullMultiple256, ObjectNullMultiple
+            // the run is skipped, the loop counts the last one
+            qint32 n;
+            if(type == 13) {
+                quint8 c;
+                if(!input.readU8(c)) return false;
+                n = c;
             }
+            else if(!input.readI32(n)) return false;
+
+            if(n < 0 || n > arraySize - i) return false;
+            i += n - 1;
+        }
+        else {
+            TBinaryObject* b = new(&recordList.arena) TBinaryObject();
+            runs.add(i);
+            objects.append(b);
+            if(!b->readNoRef(type, input, recordList)) return false;
         }
     }
 
     return true;
 }
 
+TBinaryObject* TBinaryArray::at(qint32 i)
+{
+    // NULL for a null element
+    qint32 slot = runs.find(i);
+    if(slot < 0) return NULL;
+    return objects.at(slot);
+}
+
 void TBinaryArray::write(QTextStream& outstr, int indent)
 {
     if(indent > MAX_INDENT) {outstr << "..."; return;}
@@ -1278,11 +2260,13 @@ void TBinaryArray::write(QTextStream& outstr, int indent)
         outstr << "\n";
         indentOutput(outstr, indent+2);
         outstr << "[" << i << "] ";
-        if(array[i] == NULL) {
+
+        TBinaryObject* b = at(i);
+        if(b == NULL) {
             outstr << "null";
         }
         else {
-            array[i]->write(outstr, indent + 2);
+            b->write(outstr, indent + 2);
         }
 
         if(i >= MAX_ARRAY_PRINT_SIZE) {
@@ -1296,9 +2280,9 @@ void TBinaryArray::write(QTextStream& outstr, int indent)
 
 void TBinaryArray::getReferences(QList<TBinaryType*>& list) {
 
-    for(int r=0; r<arraySize; r++) {
-        TBinaryType* b = array[r];
-        if(b != NULL && b->refID > 0) {
+    for(int r=0; r<objects.count(); r++) {
+        TBinaryType* b = objects.at(r);
+        if(b->refID > 0) {
             list.append(b);
         }
     }
@@ -1314,7 +2298,7 @@ TBinaryType* TBinaryArray::getMember(int &index, QStringList &arglist)
         int d = arglist.at(index+r).toInt(&ok, 10);
         if(!ok) return NULL;
 
-        if(d > lengths[r]) return NULL;
+        if(d < 0 || d >= lengths[r]) return NULL;
 
         i += d * offset[r];
     }
@@ -1322,49 +2306,53 @@ TBinaryType* TBinaryArray::getMember(int &index, QStringList &arglist)
     // advance list pointer
     index += rank - 1;
 
-    return array[i];
+    return at(i);
 }
 
-// --------- 8 ------------
-TMemberPrimitiveTyped::TMemberPrimitiveTyped() : TFileRecord() {
-    value = NULL;
+qint64 TBinaryArray::memorySize() {
+    qint64 size = TFileRecord::memorySize();
+    size += (qint64)rank * (2 * sizeof(qint32) + sizeof(int));
+    if(remoteType != NULL) size += remoteType->memorySize();
+    size += runs.runs.capacity() * sizeof(TRun);
+    size += objects.capacity() * sizeof(void*);
+    for(int i=0; i<objects.count(); i++) {
+        size += objects.at(i)->memorySize();
+    }
+    return size;
 }
 
-TMemberPrimitiveTyped::~TMemberPrimitiveTyped() {
-    if(value != NULL) delete value;
+// --------- 8 ------------
+TMemberPrimitiveTyped::TMemberPrimitiveTyped() : TFileRecord() {
 }
 
-bool TMemberPrimitiveTyped::read(TBinaryInput& input, QList<TFileRecord*>&) {
+bool TMemberPrimitiveTyped::read(TBinaryInput& input, TRecordList& recordList) {
 
     char type;
-    if(!input.readBytes(&type, 1)) return false;
-    classInfo.displayName = "Primitive";
-    classInfo.name = "Primitive";
+    if(!input.readChar(type)) return false;
+    classInfo.setName(recordList.names, "Primitive");
 
-    value = getPrimitiveType(type);
-    if(value == NULL) return false;
-
-    if(!value->read(input)) return false;
-
-    return true;
+    return value.read(input, type);
 }
 
 void TMemberPrimitiveTyped::write(QTextStream& outstr, int)
 {
     outstr << "Primitive ";
-    value->writeType(outstr);
-    value->write(outstr);
+    value.writeType(outstr);
+    value.write(outstr);
+}
+
+qint64 TMemberPrimitiveTyped::memorySize() {
+    return TFileRecord::memorySize() + value.heapSize();
 }
 
 // --------- 9 ------------
 TMemberReference::TMemberReference() : TFileRecord() {
 }
 
-bool TMemberReference::read(TBinaryInput& input, QList<TFileRecord*>&)
+bool TMemberReference::read(TBinaryInput& input, TRecordList& recordList)
 {
-    if(!input.readBytes((char*)&(objectID), 4)) return false;
-    classInfo.displayName = "Reference";
-    classInfo.name = "Reference";
+    if(!input.readI32(objectID)) return false;
+    classInfo.setName(recordList.names, "Reference");
 
     return true;
 }
@@ -1381,9 +2369,8 @@ void TMemberReference::getReferences(QList<TBinaryType*>&) {
 TObjectNull::TObjectNull() : TFileRecord() {
 }
 
-bool TObjectNull::read(TBinaryInput&, QList<TFileRecord*>&) {
-    classInfo.displayName = "ObjectNull";
-    classInfo.name = "ObjectNull";
+bool TObjectNull::read(TBinaryInput&, TRecordList& recordList) {
+    classInfo.setName(recordList.names, "ObjectNull");
     return true;
 }
 
@@ -1396,9 +2383,8 @@ void TObjectNull::write(QTextStream& outstr, int)
 TMessageEnd::TMessageEnd() : TFileRecord() {
 }
 
-bool TMessageEnd::read(TBinaryInput&, QList<TFileRecord*>&) {
-    classInfo.displayName = "MessageEnd";
-    classInfo.name = "MessageEnd";
+bool TMessageEnd::read(TBinaryInput&, TRecordList& recordList) {
+    classInfo.setName(recordList.names, "MessageEnd");
     return true;
 }
 
@@ -1411,11 +2397,10 @@ void TMessageEnd::write(QTextStream& outstr, int)
 TBinaryLibrary::TBinaryLibrary() : TFileRecord() {
 }
 
-bool TBinaryLibrary::read(TBinaryInput& input, QList<TFileRecord*>&) {
-    if(!input.readBytes((char*)&libraryID, 4)) return false;
+bool TBinaryLibrary::read(TBinaryInput& input, TRecordList& recordList) {
+    if(!input.readI32(libraryID)) return false;
     if(!input.readString(libraryName)) return false;
-    classInfo.displayName = "Library";
-    classInfo.name = "Library";
+    classInfo.setName(recordList.names, "Library");
     return true;
 }
 
@@ -1425,15 +2410,18 @@ void TBinaryLibrary::write(QTextStream& outstr, int)
     outstr << libraryName;
 }
 
+qint64 TBinaryLibrary::memorySize() {
+    return TFileRecord::memorySize() + libraryName.capacity() * sizeof(QChar);
+}
+
 // --------- 13 ------------
 TObjectNullMultiple256::TObjectNullMultiple256() : TFileRecord() {
 }
 
-bool TObjectNullMultiple256::read(TBinaryInput& input, QList<TFileRecord*>&) {
-    unsigned char c;
-    if(!input.readBytes((char*)&c, 1)) return false;
-    classInfo.displayName = "Null";
-    classInfo.name = "Null";
+bool TObjectNullMultiple256::read(TBinaryInput& input, TRecordList& recordList) {
+    quint8 c;
+    if(!input.readU8(c)) return false;
+    classInfo.setName(recordList.names, "Null");
     nullCount = c;
     return true;
 }
@@ -1447,10 +2435,9 @@ void TObjectNullMultiple256::write(QTextStream& outstr, int)
 TObjectNullMultiple::TObjectNullMultiple() : TFileRecord() {
 }
 
-bool TObjectNullMultiple::read(TBinaryInput& input, QList<TFileRecord*>&) {
-    if(!input.readBytes((char*)&nullCount, 4)) return false;
-    classInfo.displayName = "Null";
-    classInfo.name = "Null";
+bool TObjectNullMultiple::read(TBinaryInput& input, TRecordList& recordList) {
+    if(!input.readI32(nullCount)) return false;
+    classInfo.setName(recordList.names, "Null");
     return true;
 }
 
@@ -1465,18 +2452,17 @@ TArraySinglePrimitive::TArraySinglePrimitive() : TFileRecord() {
 }
 
 TArraySinglePrimitive::~TArraySinglePrimitive() {
-    if(array != NULL) delete array;
+    destroy(array);
 }
 
-bool TArraySinglePrimitive::read(TBinaryInput& input, QList<TFileRecord*>&) {
-    if(!input.readBytes((char*)&objectID, 4)) return false;
-    if(!input.readBytes((char*)&length, 4)) return false;
-    if(!input.readBytes(&type, 1)) return false;
-    array = getArrayType(type, length);
+bool TArraySinglePrimitive::read(TBinaryInput& input, TRecordList& recordList) {
+    if(!input.readI32(objectID)) return false;
+    if(!input.readI32(length)) return false;
+    if(!input.readChar(type)) return false;
+    array = getArrayType(type, length, &recordList.arena);
     if(array == NULL) return false;
     if(!array->read(input)) return false;
-    classInfo.displayName = "PrimitiveArray";
-    classInfo.name = "PrimitiveArray";
+    classInfo.setName(recordList.names, "PrimitiveArray");
     return true;
 }
 
@@ -1492,6 +2478,13 @@ void TArraySinglePrimitive::write(QTextStream& outstr, int indent) {
     }
 }
 
+qint64 TArraySinglePrimitive::memorySize() {
+    // nothing extra for values viewed in the input
+    qint64 size = TFileRecord::memorySize();
+    if(array != NULL) size += nodeSize(array) + array->heapSize();
+    return size;
+}
+
 bool TArraySinglePrimitive::getBoolArray(bool** a, int& len)
 {
     if(array == NULL) return false;
@@ -1510,6 +2503,24 @@ bool TArraySinglePrimitive::getDoubleArray(double** a, int& len)
     return (array->getDoubleArray(a, len));
 }
 
+bool TArraySinglePrimitive::getDecimalArray(TDecimal** a, int& len)
+{
+    if(array == NULL) return false;
+    return (array->getDecimalArray(a, len));
+}
+
+bool TArraySinglePrimitive::getDateTimeArray(TDateTimeValue** a, int& len)
+{
+    if(array == NULL) return false;
+    return (array->getDateTimeArray(a, len));
+}
+
+bool TArraySinglePrimitive::getTimeSpanArray(TTimeSpanValue** a, int& len)
+{
+    if(array == NULL) return false;
+    return (array->getTimeSpanArray(a, len));
+}
+
 bool TArraySinglePrimitive::getObjectArray(TBinaryObject*** a, int& len)
 {
     if(array == NULL) return false;
@@ -1518,141 +2529,178 @@ bool TArraySinglePrimitive::getObjectArray(TBinaryObject*** a, int& len)
 
 // --------- 16 ------------
 TArraySingleObject::TArraySingleObject() : TFileRecord() {
-    objectArray = NULL;
-    typeArray = NULL;
-    doubleArray = NULL;
-    int32Array = NULL;
-    int64Array = NULL;
-    boolArray = NULL;
     length = 0;
+    elementType = ELEMENT_NULL;
+    expanded = NULL;
+    expandedObjects = NULL;
 }
 
 TArraySingleObject::~TArraySingleObject() {
-    if(objectArray != NULL) {
-        for(int i=0; i<length; i++) {
-            if(objectArray[i] != NULL) delete objectArray[i];
+    for(int i=0; i<runs.slots; i++) {
+        char t = typeArray.at(i);
+        if(t == ELEMENT_OBJECT) {
+            destroy(objectAt(i));
         }
-        delete[] objectArray;
+        else if(t == 3 || t == 18) delete (QString*)(quintptr)cells.at(i);
+        else if(t == 5) delete (TDecimal*)(quintptr)cells.at(i);
     }
-    if(typeArray != NULL) delete[] typeArray;
-    if(doubleArray != NULL) delete[] doubleArray;
-    if(int32Array != NULL) delete[] int32Array;
-    if(int64Array != NULL) delete[] int64Array;
-    if(boolArray != NULL) delete[] boolArray;
+    if(expanded != NULL) delete[] expanded;
+    if(expandedObjects != NULL) delete[] expandedObjects;
 }
 
-bool TArraySingleObject::read(TBinaryInput& input, QList<TFileRecord*>& recordList) {
-    if(!input.readBytes((char*)&objectID, 4)) return false;
-    if(!input.readBytes((char*)&length, 4)) return false;
-    classInfo.displayName = "ArraySingleObject";
-    classInfo.name = "ArraySingleObject";
-
-    if(length == 0) return true;
-
-    // 0 for null
-    // primitive type 6 - double, 8 - int32
-    // -1 for object
+bool TArraySingleObject::read(TBinaryInput& input, TRecordList& recordList) {
+    if(!input.readI32(objectID)) return false;
+    if(!input.readI32(length)) return false;
+    classInfo.setName(recordList.names, "ArraySingleObject");
 
-    typeArray = new char[length];
-    memset(typeArray, 0, length*sizeof(char));
+    if(length < 0) {
+        length = 0;
+        return false;
+    }
 
-    // objects loaded here to add multiple nulls to count
     for(int m=0; m<length; m++) {
         char ref;
-        if(!input.readBytes(&ref, 1)) return false;
+        if(!input.readChar(ref)) return false;
 
         // no arrays within arrays
         if(ref == 16) return false;
 
-        if(ref == 13) {
-            // ObjectNullMultiple256
-            unsigned char n;
-            if(!input.readBytes((char*)&n, 1)) return false;
-
-            if(objectArray != NULL) {
-                for(int i=0; i<n; i++) {
-                    objectArray[m+i] = NULL;
-                }
-            }
-            m += n;
+        if(ref == 10) {
+            // ObjectNull, as in Array the element is left null
         }
-        else if(ref == 14) {
-            // ObjectNullMultiple
+        else if(ref == 13 || ref == 14) {
+            // ObjectNullMultiple256, ObjectNullMultiple
             qint32 n;
-            if(!input.readBytes((char*)&n, 4)) return false;
-
-            if(objectArray != NULL) {
-                for(int i=0; i<n; i++) {
-                    objectArray[m+i] = NULL;
-                }
+            if(ref == 13) {
+                quint8 c;
+                if(!input.readU8(c)) return false;
+                n = c;
             }
-            m += n;
+            else if(!input.readI32(n)) return false;
+
+            if(n < 0 || n > length - m) return false;
+
+            // the run is skipped, the loop counts the last one
+            m += n - 1;
         }
         else if(ref == 8) {
             // primitive
             char type;
-            if(!input.readBytes((char*)&type, 1)) return false;
-
-            typeArray[m] = type;
-
-            if(type == 1) {
-                // bool
-                if(boolArray == NULL) {
-                    boolArray = new bool[length];
-                    memset(boolArray, 0, length*sizeof(bool));
-                }
-                char inp;
-                if(!input.readBytes((char*)&inp, 1)) return false;
-                boolArray[m] = (inp != 0);
-            }
-            else if(type == 6) {
-                // double
-                if(doubleArray == NULL) {
-                    doubleArray = new double[length];
-                    memset(doubleArray, 0, length*sizeof(double));
-                }
-                if(!input.readBytes((char*)&(doubleArray[m]), 8)) return false;
-            }
-            else if(type == 8) {
-                // int32
-                if(int32Array == NULL) {
-                    int32Array = new qint32[length];
-                    memset(int32Array, 0, length*sizeof(qint32));
-                }
-                if(!input.readBytes((char*)&(int32Array[m]), 4)) return false;
-            }
-            else if(type == 9) {
-                // int64
-                if(int64Array == NULL) {
-                    int64Array = new qint64[length];
-                    memset(int64Array, 0, length*sizeof(qint64));
-                }
-                if(!input.readBytes((char*)&(int64Array[m]), 8)) return false;
-            }
-
-            // type not implemented
-            else return false;
-
+            if(!input.readChar(type)) return false;
+            if(!readPrimitive(input, m, type)) return false;
         }
         else {
             // reference to object
-            if(objectArray == NULL) {
-                objectArray = new TBinaryObject*[length];
-                for(int i=0; i<length; i++) {
-                    objectArray[i] = NULL;
-                }
-            }
+            qint32 slot = addSlot(m, ELEMENT_OBJECT);
+            if(slot < 0) return false;
 
-            objectArray[m] = new TBinaryObject();
-            if(!objectArray[m]->readNoRef(ref, input, recordList)) return false;
+            TBinaryObject* b = new(&recordList.arena) TBinaryObject();
+            if(usesCells()) cells[slot] = (quintptr)b;
+            else objectArray[slot] = b;
 
-            typeArray[m] = -1;
+            if(!b->readNoRef(ref, input, recordList)) return false;
         }
     }
 
     return true;
 }
 
+bool TArraySingleObject::readPrimitive(TBinaryInput& input, int i, char type) {
+    if(!TValue::isValidType(type)) return false;
+
+    // a null primitive leaves the element null
+    if(type == 17) return true;
+
+    qint32 slot = addSlot(i, type);
+    if(slot < 0) return false;
+
+    if(TValue::fixedSize(type) > 0) {
+        return TValue::readFixed(input, type, valueAt(slot));
+    }
+
+    // char, decimal and string hang off the cell
+    if(type == 5) {
+        TDecimal* d = new TDecimal();
+        cells[slot] = (quintptr)d;
+        return input.readDecimal(*d);
+    }
+
+    QString* str = new QString();
+    cells[slot] = (quintptr)str;
+    if(type == 3) return input.readChars(*str, 1);
+    return input.readString(*str);
+}
+
+qint32 TArraySingleObject::addSlot(qint32 element, char tag) {
+    // first element decides the storage, a second kind moves to cells
+    // storage grows as slots are added, not by the length of the array
+    // since a list's unused capacity is a null run after its items
+    // returns -1 if the packed values would not fit in a QByteArray
+    if(elementType == ELEMENT_NULL) {
+        elementType = tag;
+    }
+    else if(elementType != tag && elementType != ELEMENT_MIXED) {
+        toCells();
+        elementType = ELEMENT_MIXED;
+    }
+
+    qint64 size = TValue::fixedSize(elementType);
+    if(!usesCells() && (runs.slots + 1) * size > INT_MAX) return -1;
+
+    qint32 slot = runs.add(element);
+    typeArray.append(tag);
+
+    if(usesCells()) {
+        cells.append(0);
+    }
+    else if(elementType == ELEMENT_OBJECT) {
+        objectArray.append(NULL);
+    }
+    else {
+        values.resize((int)((slot + 1) * size));
+        memset(values.data() + slot * size, 0, size);
+    }
+    return slot;
+}
+
+bool TArraySingleObject::usesCells() {
+    if(elementType == ELEMENT_MIXED) return true;
+    return elementType != ELEMENT_OBJECT && TValue::fixedSize(elementType) == 0;
+}
+
+void TArraySingleObject::toCells() {
+    // a second kind of element, move the slots so far to cells
+    if(usesCells()) return;
+
+    int count = runs.slots;
+    cells.fill(0, count);
+
+    if(elementType == ELEMENT_OBJECT) {
+        for(int i=0; i<count; i++) {
+            cells[i] = (quintptr)objectArray.at(i);
+        }
+        objectArray.clear();
+    }
+    else {
+        int size = TValue::fixedSize(elementType);
+        for(int i=0; i<count; i++) {
+            memcpy(&cells[i], values.constData() + (size_t)i * size, size);
+        }
+        values.clear();
+    }
+}
+
+char* TArraySingleObject::valueAt(qint32 slot) {
+    // fixed size primitive, packed or at the start of its cell
+    if(usesCells()) return (char*)&cells[slot];
+    return values.data() + (size_t)slot * TValue::fixedSize(elementType);
+}
+
+TBinaryObject* TArraySingleObject::objectAt(qint32 slot) {
+    if(usesCells()) return (TBinaryObject*)(quintptr)cells.at(slot);
+    return objectArray.at(slot);
+}
+
 void TArraySingleObject::write(QTextStream& outstr, int indent)
 {
     if(indent > MAX_INDENT) {outstr << "..."; return;}
@@ -1665,25 +2713,27 @@ void TArraySingleObject::write(QTextStream& outstr, int indent)
         indentOutput(outstr, indent + 1);
         outstr << "[" << i << "] ";
 
-        if(typeArray[i] == 0) {
+        qint32 slot = runs.find(i);
+        char t = (slot < 0) ? ELEMENT_NULL : typeArray.at(slot);
+
+        if(t == ELEMENT_NULL) {
             outstr << "null";
         }
-        else if(typeArray[i] == 1 && boolArray != NULL){
-            if(boolArray[i]) outstr << "true";
-            else outstr << "false";
+        else if(t == ELEMENT_OBJECT) {
+            TBinaryObject* b = objectAt(slot);
+            if(b == NULL) outstr << "null";
+            else b->write(outstr, indent+1);
         }
-        else if(typeArray[i] == 6 && doubleArray != NULL){
-            outstr << doubleArray[i];
+        else if(t == 3 || t == 18) {
+            outstr << *(QString*)(quintptr)cells.at(slot);
         }
-        else if(typeArray[i] == 8 && int32Array != NULL){
-            outstr << int32Array[i];
+        else if(t == 5) {
+            outstr << ((TDecimal*)(quintptr)cells.at(slot))->toString();
         }
-        else if(typeArray[i] == 9 && int64Array != NULL){
-            outstr << int64Array[i];
-        }
-        else if(typeArray[i] == -1 && objectArray != NULL){
-            if(objectArray[i] == NULL) outstr << "null";
-            else objectArray[i]->write(outstr, indent+1);
+        else {
+            TValue value;
+            value.load(t, valueAt(slot));
+            value.write(outstr);
         }
 
         if(i >= MAX_ARRAY_PRINT_SIZE) {
@@ -1697,12 +2747,11 @@ void TArraySingleObject::write(QTextStream& outstr, int indent)
 
 void TArraySingleObject::getReferences(QList<TBinaryType*>& btlist)
 {
-    if(typeArray != NULL && objectArray != NULL) {
-        for(int i=0; i<length; i++) {
-            if(typeArray[i] == -1 && objectArray[i] != NULL) {
-                if(objectArray[i]->refID > 0) {
-                    btlist.append(objectArray[i]);
-                }
+    for(int i=0; i<runs.slots; i++) {
+        if(typeArray.at(i) == ELEMENT_OBJECT) {
+            TBinaryObject* b = objectAt(i);
+            if(b != NULL && b->refID > 0) {
+                btlist.append(b);
             }
         }
     }
@@ -1711,7 +2760,7 @@ void TArraySingleObject::getReferences(QList<TBinaryType*>& btlist)
 TBinaryType* TArraySingleObject::getMember(int &index, QStringList &arglist)
 {
     // to avoid having to create binarytype from primitives
-    // this only works if it is an array of objects
+    // this only works for elements that are objects
     // for primitives use getArray to get the whole array
 
     QString str = arglist.at(index);
@@ -1719,38 +2768,135 @@ TBinaryType* TArraySingleObject::getMember(int &index, QStringList &arglist)
         // index number
         bool ok;
         int i = str.toInt(&ok, 10);
-        if(!ok || i > length || objectArray == NULL) return NULL;
-        return objectArray[i];
+        if(!ok || i < 0 || i >= length) return NULL;
+
+        qint32 slot = runs.find(i);
+        if(slot < 0 || typeArray.at(slot) != ELEMENT_OBJECT) return NULL;
+        return objectAt(slot);
     }
     return NULL;
 }
 
+qint64 TArraySingleObject::memorySize() {
+    // the copies made by the getters come later and are not counted
+    qint64 size = TFileRecord::memorySize();
+    size += runs.runs.capacity() * sizeof(TRun);
+    size += typeArray.capacity() + values.capacity();
+    size += objectArray.capacity() * sizeof(void*);
+    size += cells.capacity() * sizeof(quint64);
+
+    for(int i=0; i<runs.slots; i++) {
+        char t = typeArray.at(i);
+        if(t == ELEMENT_OBJECT) {
+            TBinaryObject* b = objectAt(i);
+            if(b != NULL) size += b->memorySize();
+        }
+        else if(t == 3 || t == 18) {
+            size += sizeof(QString) + ((QString*)(quintptr)cells.at(i))->capacity() * sizeof(QChar);
+        }
+        else if(t == 5) size += sizeof(TDecimal);
+    }
+    return size;
+}
+
+// whole arrays only when every element that is not null has the type
+// null elements are 0, which needs a copy by element if there are any
+
+char* TArraySingleObject::elementValues(char type)
+{
+    if(elementType != type || usesCells()) return NULL;
+    if(runs.isDense(length)) return values.data();
+
+    if(expanded == NULL) {
+        int size = TValue::fixedSize(type);
+        expanded = new char[(size_t)length * size];
+        memset(expanded, 0, (size_t)length * size);
+
+        for(int r=0; r<runs.runs.count(); r++) {
+            const TRun& run = runs.runs.at(r);
+            memcpy(expanded + (size_t)run.start * size, values.constData() + (size_t)run.slot * size, (size_t)run.count * size);
+        }
+    }
+    return expanded;
+}
+
 bool TArraySingleObject::getBoolArray(bool** array, int& len)
 {
     len = length;
-    *array = boolArray;
-    return (boolArray != NULL);
+    *array = (bool*)elementValues(1);
+    return (*array != NULL);
 }
 
 bool TArraySingleObject::getInt32Array(qint32** array, int& len)
 {
     len = length;
-    *array = int32Array;
-    return (int32Array != NULL);
+    *array = (qint32*)elementValues(8);
+    return (*array != NULL);
 }
 
 bool TArraySingleObject::getDoubleArray(double** array, int& len)
 {
     len = length;
-    *array = doubleArray;
-    return (doubleArray != NULL);
+    *array = (double*)elementValues(6);
+    return (*array != NULL);
+}
+
+bool TArraySingleObject::getDateTimeArray(TDateTimeValue** array, int& len)
+{
+    len = length;
+    *array = (TDateTimeValue*)elementValues(13);
+    return (*array != NULL);
+}
+
+bool TArraySingleObject::getTimeSpanArray(TTimeSpanValue** array, int& len)
+{
+    len = length;
+    *array = (TTimeSpanValue*)elementValues(12);
+    return (*array != NULL);
+}
+
+bool TArraySingleObject::getStringArray(QStringList& list)
+{
+    // null elements give empty strings
+    if(elementType != 18 && elementType != 3) return false;
+
+    qint32 next = 0;
+    for(int r=0; r<runs.runs.count(); r++) {
+        const TRun& run = runs.runs.at(r);
+        for(; next<run.start; next++) list.append(QString());
+        for(int i=0; i<run.count; i++) {
+            list.append(*(QString*)(quintptr)cells.at(run.slot + i));
+        }
+        next = run.start + run.count;
+    }
+    for(; next<length; next++) list.append(QString());
+    return true;
 }
 
 bool TArraySingleObject::getObjectArray(TBinaryObject*** array, int& len)
 {
     len = length;
-    *array = objectArray;
-    return (objectArray != NULL);
+    *array = NULL;
+    if(elementType != ELEMENT_OBJECT) return false;
+
+    if(runs.isDense(length)) {
+        *array = objectArray.data();
+        return true;
+    }
+
+    if(expandedObjects == NULL) {
+        expandedObjects = new TBinaryObject*[length];
+        memset(expandedObjects, 0, length*sizeof(TBinaryObject*));
+
+        for(int r=0; r<runs.runs.count(); r++) {
+            const TRun& run = runs.runs.at(r);
+            for(int i=0; i<run.count; i++) {
+                expandedObjects[run.start + i] = objectArray.at(run.slot + i);
+            }
+        }
+    }
+    *array = expandedObjects;
+    return true;
 }
 
 // --------- 17 ------------
@@ -1760,35 +2906,34 @@ TArraySingleString::TArraySingleString() : TFileRecord() {
 TArraySingleString::~TArraySingleString() {
 }
 
-bool TArraySingleString::read(TBinaryInput& input, QList<TFileRecord*>& recordList) {
-    if(!input.readBytes((char*)&objectID, 4)) return false;
+bool TArraySingleString::read(TBinaryInput& input, TRecordList& recordList) {
+    if(!input.readI32(objectID)) return false;
     qint32 length;
-    if(!input.readBytes((char*)&length, 4)) return false;
-    classInfo.displayName = "ArraySingleString";
-    classInfo.name = "ArraySingleString";
+    if(!input.readI32(length)) return false;
+    classInfo.setName(recordList.names, "ArraySingleString");
 
     // objects loaded here to add multiple nulls to count
     for(int m=0; m<length; m++) {
         char ref;
-        if(!input.readBytes(&ref, 1)) return false;
+        if(!input.readChar(ref)) return false;
 
         // no arrays within arrays
         if(ref == 16) return false;
 
         if(ref == 13) {
             // ObjectNullMultiple256
-            unsigned char n;
-            if(!input.readBytes((char*)&n, 1)) return false;
+            quint8 n;
+            if(!input.readU8(n)) return false;
             m += n;
         }
         else if(ref == 14) {
             // ObjectNullMultiple
             qint32 n;
-            if(!input.readBytes((char*)&n, 4)) return false;
+            if(!input.readI32(n)) return false;
             m += n;
         }
         else {
-            TBinaryString* str = new TBinaryString();
+            TBinaryString* str = new(&recordList.arena) TBinaryString();
             str->readNoRef(ref, input, recordList);
             memberList.append(str);
         }
@@ -1824,18 +2969,17 @@ bool TArraySingleString::getStringArray(QStringList& list)
 TMethodCall::TMethodCall() : TFileRecord() {
 }
 
-bool TMethodCall::read(TBinaryInput& input, QList<TFileRecord*>&) {
-    if(!input.readBytes((char*)&messageFlags, 4)) return false;
+bool TMethodCall::read(TBinaryInput& input, TRecordList& recordList) {
+    if(!input.readI32(messageFlags)) return false;
     if(!input.readStringWithCode(methodName)) return false;
     if(!input.readStringWithCode(typeName)) return false;
-    classInfo.displayName = "MethodCall";
-    classInfo.name = "MethodCall";
+    classInfo.setName(recordList.names, "MethodCall");
 
     if((messageFlags & MESSAGE_CONTEXTINLINE) != 0) {
         if(!input.readStringWithCode(callContext)) return false;
     }
     if((messageFlags & MESSAGE_ARGSINLINE) != 0) {
-        if(!input.readArrayOfValueWithCode(args)) return false;
+        if(!input.readArrayOfValueWithCode(args, &recordList.arena)) return false;
     }
     return false;
 }
@@ -1849,18 +2993,17 @@ void TMethodCall::write(QTextStream& outstr, int)
 TMethodReturn::TMethodReturn() : TFileRecord() {
 }
 
-bool TMethodReturn::read(TBinaryInput& input, QList<TFileRecord*>&) {
-    if(!input.readBytes((char*)&messageFlags, 4)) return false;
+bool TMethodReturn::read(TBinaryInput& input, TRecordList& recordList) {
+    if(!input.readI32(messageFlags)) return false;
     if(!input.readStringWithCode(methodName)) return false;
     if(!input.readStringWithCode(typeName)) return false;
-    classInfo.displayName = "MethodReturn";
-    classInfo.name = "MethodReturn";
+    classInfo.setName(recordList.names, "MethodReturn");
 
     if((messageFlags & MESSAGE_CONTEXTINLINE) != 0) {
         if(!input.readStringWithCode(callContext)) return false;
     }
     if((messageFlags & MESSAGE_ARGSINLINE) != 0) {
-        if(!input.readArrayOfValueWithCode(args)) return false;
+        if(!input.readArrayOfValueWithCode(args, &recordList.arena)) return false;
     }
     return false;
 }
@@ -1874,6 +3017,41 @@ void TMethodReturn::write(QTextStream& outstr, int)
 // ArrayTypeEnumeration
 // ==========================================
 
+// arrays of fixed size values are allocated when read
+// on a persistent input with INPUT_ARRAY_VIEWS value points into the input
+// and owned is false, unless the data is misaligned for T
+// the array node then owns nothing and is marked plain
+// without a view of the whole array it is copied as usual
+template<typename T> bool readArrayValues(TBinaryInput& input, TPrimitiveType* array, T*& value, qint32& length, bool& owned)
+{
+    if(length < 0) return false;
+    qint64 size = (qint64)length * sizeof(T);
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const int viewFlags = INPUT_PERSISTENT | INPUT_ARRAY_VIEWS;
+    if((input.flags & viewFlags) == viewFlags && input.persistent() && size <= INT_MAX) {
+        const char* view = input.readView((int)size);
+        if(view != NULL) {
+            if((quintptr)view % alignof(T) == 0) {
+                value = (T*)view;
+                owned = false;
+                array->setPlain(true);
+            }
+            else {
+                value = new T[length];
+                owned = true;
+                memcpy(value, view, size);
+            }
+            return true;
+        }
+    }
+#endif
+
+    value = new T[length];
+    owned = true;
+    return input.readArray(value, length, sizeof(T));
+}
+
 // --------- 1 ------------
 TArrayBoolean::TArrayBoolean(int len) {
     length = len;
@@ -1885,11 +3063,9 @@ TArrayBoolean::~TArrayBoolean() {
 }
 
 bool TArrayBoolean::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        char b;
-        if(!input.readBytes(&b, 1)) return false;
-        value[i] = (b != 0);
-    }
+    // any non zero byte is true
+    if(!input.readArray(value, length, sizeof(bool))) return false;
+    normaliseBools((char*)value, length);
     return true;
 }
 
@@ -1920,18 +3096,16 @@ bool TArrayBoolean::getBoolArray(bool** array, int& len)
 // --------- 2 ------------
 TArrayByte::TArrayByte(int len) {
     length = len;
-    value = new char[len];
+    value = NULL;
+    owned = false;
 }
 
 TArrayByte::~TArrayByte() {
-    delete[] value;
+    if(owned) delete[] value;
 }
 
 bool TArrayByte::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        if(!input.readBytes(&(value[i]), 1)) return false;
-    }
-    return true;
+    return readArrayValues(input, this, value, length, owned);
 }
 void TArrayByte::write(QTextStream& outstr)
 {
@@ -1951,15 +3125,14 @@ void TArrayByte::writeType(QTextStream& outstr){
 // --------- 3 ------------
 TArrayChar::TArrayChar(int len) {
     length = len;
-    value.reserve(len);
 }
 
 TArrayChar::~TArrayChar() {
 
 }
 
-bool TArrayChar::read(TBinaryInput&){
-    return false;
+bool TArrayChar::read(TBinaryInput& input){
+    return input.readChars(value, length);
 }
 void TArrayChar::write(QTextStream& outstr)
 {
@@ -1979,21 +3152,26 @@ void TArrayChar::writeType(QTextStream& outstr){
 // --------- 5 ------------
 TArrayDecimal::TArrayDecimal(int len) {
     length = len;
-    value = new double[len];
+    value = new TDecimal[len];
+    doubles = NULL;
 }
 
 TArrayDecimal::~TArrayDecimal() {
     delete[] value;
+    delete[] doubles;
 }
 
-bool TArrayDecimal::read(TBinaryInput&){
-    return false;
+bool TArrayDecimal::read(TBinaryInput& input){
+    for(int i=0; i<length; i++) {
+        if(!input.readDecimal(value[i])) return false;
+    }
+    return true;
 }
 
 void TArrayDecimal::write(QTextStream& outstr)
 {
     for(int i=0; i<length; i++) {
-        outstr << " [" << i << "]" << value[i];
+        outstr << " [" << i << "]" << value[i].toString();
 
         if(i >= MAX_ARRAY_PRINT_SIZE) {
             outstr << " ...";
@@ -2007,6 +3185,20 @@ void TArrayDecimal::writeType(QTextStream& outstr){
 }
 
 bool TArrayDecimal::getDoubleArray(double** array, int& len)
+{
+    if(doubles == NULL) {
+        doubles = new double[length];
+        for(int i=0; i<length; i++) {
+            doubles[i] = value[i].toDouble();
+        }
+    }
+
+    len = length;
+    *array = doubles;
+    return true;
+}
+
+bool TArrayDecimal::getDecimalArray(TDecimal** array, int& len)
 {
     len = length;
     *array = value;
@@ -2016,18 +3208,16 @@ bool TArrayDecimal::getDoubleArray(double** array, int& len)
 // --------- 6 ------------
 TArrayDouble::TArrayDouble(int len) {
     length = len;
-    value = new double[len];
+    value = NULL;
+    owned = false;
 }
 
 TArrayDouble::~TArrayDouble() {
-    delete[] value;
+    if(owned) delete[] value;
 }
 
 bool TArrayDouble::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        if(!input.readBytes((char*)&(value[i]), 8)) return false;
-    }
-    return true;
+    return readArrayValues(input, this, value, length, owned);
 }
 
 void TArrayDouble::write(QTextStream& outstr)
@@ -2056,18 +3246,16 @@ bool TArrayDouble::getDoubleArray(double** array, int& len)
 // --------- 7 ------------
 TArrayInt16::TArrayInt16(int len) {
     length = len;
-    value = new qint16[len];
+    value = NULL;
+    owned = false;
 }
 
 TArrayInt16::~TArrayInt16() {
-    delete[] value;
+    if(owned) delete[] value;
 }
 
 bool TArrayInt16::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        if(!input.readBytes((char*)&(value[i]), 2)) return false;
-    }
-    return true;
+    return readArrayValues(input, this, value, length, owned);
 }
 
 void TArrayInt16::write(QTextStream& outstr)
@@ -2089,18 +3277,16 @@ void TArrayInt16::writeType(QTextStream& outstr){
 // --------- 8 ------------
 TArrayInt32::TArrayInt32(int len) {
     length = len;
-    value = new qint32[len];
+    value = NULL;
+    owned = false;
 }
 
 TArrayInt32::~TArrayInt32() {
-    delete[] value;
+    if(owned) delete[] value;
 }
 
 bool TArrayInt32::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        if(!input.readBytes((char*)&(value[i]), 4)) return false;
-    }
-    return true;
+    return readArrayValues(input, this, value, length, owned);
 }
 
 void TArrayInt32::write(QTextStream& outstr)
@@ -2129,18 +3315,16 @@ bool TArrayInt32::getInt32Array(qint32** array, int& len)
 // --------- 9 ------------
 TArrayInt64::TArrayInt64(int len) {
     length = len;
-    value = new qint64[len];
+    value = NULL;
+    owned = false;
 }
 
 TArrayInt64::~TArrayInt64() {
-    delete[] value;
+    if(owned) delete[] value;
 }
 
 bool TArrayInt64::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        if(!input.readBytes((char*)&(value[i]), 8)) return false;
-    }
-    return true;
+    return readArrayValues(input, this, value, length, owned);
 }
 
 void TArrayInt64::write(QTextStream& outstr)
@@ -2162,18 +3346,16 @@ void TArrayInt64::writeType(QTextStream& outstr){
 // --------- 10 ------------
 TArraySByte::TArraySByte(int len) {
     length = len;
-    value = new char[len];
+    value = NULL;
+    owned = false;
 }
 
 TArraySByte::~TArraySByte() {
-    delete[] value;
+    if(owned) delete[] value;
 }
 
 bool TArraySByte::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        if(!input.readBytes(&(value[i]), 1)) return false;
-    }
-    return true;
+    return readArrayValues(input, this, value, length, owned);
 }
 
 void TArraySByte::write(QTextStream& outstr)
@@ -2195,18 +3377,16 @@ void TArraySByte::writeType(QTextStream& outstr){
 // --------- 11 ------------
 TArraySingle::TArraySingle(int len) {
     length = len;
-    value = new float[len];
+    value = NULL;
+    owned = false;
 }
 
 TArraySingle::~TArraySingle() {
-    delete[] value;
+    if(owned) delete[] value;
 }
 
 bool TArraySingle::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        if(!input.readBytes((char*)&(value[i]), 4)) return false;
-    }
-    return true;
+    return readArrayValues(input, this, value, length, owned);
 }
 
 void TArraySingle::write(QTextStream& outstr)
@@ -2228,24 +3408,22 @@ void TArraySingle::writeType(QTextStream& outstr){
 // --------- 12 ------------
 TArrayTimeSpan::TArrayTimeSpan(int len) {
     length = len;
-    value = new qint64[len];
+    value = NULL;
+    owned = false;
 }
 
 TArrayTimeSpan::~TArrayTimeSpan() {
-    delete[] value;
+    if(owned) delete[] value;
 }
 
 bool TArrayTimeSpan::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        if(!input.readBytes((char*)&(value[i]), 8)) return false;
-    }
-    return true;
+    return readArrayValues(input, this, value, length, owned);
 }
 
 void TArrayTimeSpan::write(QTextStream& outstr)
 {
     for(int i=0; i<length; i++) {
-        outstr << " [" << i << "]" << value[i];
+        outstr << " [" << i << "]" << value[i].ticks;
 
         if(i >= MAX_ARRAY_PRINT_SIZE) {
             outstr << " ...";
@@ -2258,27 +3436,32 @@ void TArrayTimeSpan::writeType(QTextStream& outstr){
     outstr << " (time array) ";
 }
 
+bool TArrayTimeSpan::getTimeSpanArray(TTimeSpanValue** array, int& len)
+{
+    len = length;
+    *array = value;
+    return true;
+}
+
 // --------- 13 ------------
 TArrayDateTime::TArrayDateTime(int len) {
     length = len;
-    value = new qint64[len];
+    value = NULL;
+    owned = false;
 }
 
 TArrayDateTime::~TArrayDateTime() {
-    delete[] value;
+    if(owned) delete[] value;
 }
 
 bool TArrayDateTime::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        if(!input.readBytes((char*)&(value[i]), 8)) return false;
-    }
-    return true;
+    return readArrayValues(input, this, value, length, owned);
 }
 
 void TArrayDateTime::write(QTextStream& outstr)
 {
     for(int i=0; i<length; i++) {
-        outstr << " [" << i << "]" << value[i];
+        outstr << " [" << i << "]" << (qint64)value[i].raw;
 
         if(i >= MAX_ARRAY_PRINT_SIZE) {
             outstr << " ...";
@@ -2291,21 +3474,26 @@ void TArrayDateTime::writeType(QTextStream& outstr){
     outstr << " (timedate array) ";
 }
 
+bool TArrayDateTime::getDateTimeArray(TDateTimeValue** array, int& len)
+{
+    len = length;
+    *array = value;
+    return true;
+}
+
 // --------- 14 ------------
 TArrayUInt16::TArrayUInt16(int len) {
     length = len;
-    value = new quint16[len];
+    value = NULL;
+    owned = false;
 }
 
 TArrayUInt16::~TArrayUInt16() {
-    delete[] value;
+    if(owned) delete[] value;
 }
 
 bool TArrayUInt16::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        if(!input.readBytes((char*)&(value[i]), 2)) return false;
-    }
-    return true;
+    return readArrayValues(input, this, value, length, owned);
 }
 
 void TArrayUInt16::write(QTextStream& outstr)
@@ -2327,18 +3515,16 @@ void TArrayUInt16::writeType(QTextStream& outstr){
 // --------- 15 ------------
 TArrayUInt32::TArrayUInt32(int len) {
     length = len;
-    value = new quint32[len];
+    value = NULL;
+    owned = false;
 }
 
 TArrayUInt32::~TArrayUInt32() {
-    delete[] value;
+    if(owned) delete[] value;
 }
 
 bool TArrayUInt32::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        if(!input.readBytes((char*)&(value[i]), 4)) return false;
-    }
-    return true;
+    return readArrayValues(input, this, value, length, owned);
 }
 
 void TArrayUInt32::write(QTextStream& outstr)
@@ -2360,18 +3546,16 @@ void TArrayUInt32::writeType(QTextStream& outstr){
 // --------- 16 ------------
 TArrayUInt64::TArrayUInt64(int len) {
     length = len;
-    value = new quint64[len];
+    value = NULL;
+    owned = false;
 }
 
 TArrayUInt64::~TArrayUInt64() {
-    delete[] value;
+    if(owned) delete[] value;
 }
 
 bool TArrayUInt64::read(TBinaryInput& input){
-    for(int i=0; i<length; i++) {
-        if(!input.readBytes((char*)&(value[i]), 8)) return false;
-    }
-    return true;
+    return readArrayValues(input, this, value, length, owned);
 }
 
 void TArrayUInt64::write(QTextStream& outstr)
@@ -2412,7 +3596,7 @@ void TArrayNull::writeType(QTextStream& outstr){
 // --------- 18 ------------
 TArrayString::TArrayString(int len) {
     length = len;
-    value.reserve(len);
+    offsets.reserve(len + 1);
 }
 
 TArrayString::~TArrayString() {
@@ -2420,17 +3604,36 @@ TArrayString::~TArrayString() {
 }
 
 bool TArrayString::read(TBinaryInput& input){
+    // all strings go into one buffer, offsets[i] is where string i starts
+    offsets.append(0);
     for(int i=0; i<length; i++) {
-        QString str;
-        if(!input.readString(str)) return false;
-        value.append(str);
+        qint32 strsize;
+        if(!input.readVariableInt(strsize)) return false;
+
+        const char* view = input.readView(strsize);
+        if(view != NULL) {
+            utf8.append(view, strsize);
+        } else {
+            int pos = utf8.size();
+            utf8.resize(pos + strsize);
+            if(!input.readBytes(utf8.data() + pos, strsize)) return false;
+        }
+        offsets.append(utf8.size());
     }
     return true;
 }
+
+QString TArrayString::at(int i) {
+    QString str;
+    qint32 start = offsets.at(i);
+    decodeString(utf8.constData() + start, offsets.at(i + 1) - start, str);
+    return str;
+}
+
 void TArrayString::write(QTextStream& outstr)
 {
     for(int i=0; i<length; i++) {
-        outstr << " [" << i << "]" << value[i];
+        outstr << " [" << i << "]" << at(i);
 
         if(i >= MAX_ARRAY_PRINT_SIZE) {
             outstr << " ...";
@@ -2442,13 +3645,56 @@ void TArrayString::writeType(QTextStream& outstr){
     outstr << " (string array) ";
 }
 
+// ==========================================
+// TMemoryStats
+// ==========================================
+
+void TMemoryStats::add(TFileRecord* record)
+{
+    qint64 bytes = record->memorySize();
+    total += bytes;
+    if(record->type >= 0 && record->type < 23) byType[record->type] += bytes;
+
+    qint32 nameID = record->classInfo.displayNameID;
+    if(record->type == 1) {
+        TClassSchema* schema = ((TClassWithId*)record)->schema;
+        if(schema != NULL) nameID = schema->classInfo.displayNameID;
+    }
+    byClass[nameID] += bytes;
+
+    if(record->type == 15) {
+        TArraySinglePrimitive* a = (TArraySinglePrimitive*)record;
+        TArrayMemory m;
+        m.objectID = a->objectID;
+        m.typeEnum = a->type;
+        m.length = a->length;
+        m.bytes = bytes;
+        arrays.append(m);
+    }
+}
+
+void TMemoryStats::setOverhead(qint64 bytes)
+{
+    total += bytes - overhead;
+    overhead = bytes;
+}
+
+void TMemoryStats::clear()
+{
+    total = 0;
+    overhead = 0;
+    memset(byType, 0, sizeof(byType));
+    byClass.clear();
+    arrays.clear();
+}
+
 // ==========================================
 // TStream
 // ==========================================
 
 TStream::TStream()
 {
-
+    accounted = 0;
 }
 
 TStream::~TStream()
@@ -2466,25 +3712,44 @@ int TStream::read(TBinaryInput& input)
     char c = 0;
     while(c != 0x0b) {
 
-        if(!input.readBytes(&c, 1)) return DESERIAL_RECORD_READ_FAILED;
+        input.beginRecord();
+        if(!input.readChar(c)) return DESERIAL_RECORD_READ_FAILED;
+        input.setRecordType(c);
+
         if(c != 0x0b) {
+
             // don't include end message record
-            TFileRecord* record = getRecordType(c);
+            TFileRecord* record = getRecordType(c, &recordList.arena);
             if(record == NULL) {
                 return DESERIAL_UNKNOWN_RECORD;
             }
 
             if(!record->read(input, recordList)) {
+                delete record;
                 return DESERIAL_RECORD_READ_FAILED;
             }
 
             recordList.append(record);
+            recordList.updateIndex();
+
+            addMemory();
         }
     }
 
     return DESERIAL_OK;
 }
 
+void TStream::addMemory()
+{
+    // records appended since the last call, those nested in members first
+    for(; accounted < recordList.count(); accounted++) {
+        memory.add(recordList.at(accounted));
+    }
+
+    qint64 unused = recordList.arena.reservedBytes() - recordList.arena.usedBytes();
+    memory.setOverhead(recordList.names.memorySize() + recordList.count() * sizeof(void*) + unused);
+}
+
 void TStream::write(QTextStream& ts)
 {
     for(int i=0; i<recordList.size(); i++) {
@@ -2500,287 +3765,996 @@ void TStream::write(QTextStream& ts)
     }
 }
 
-void TStream::clearList()
+void TStream::clearList()
+{
+    for (int i = 0; i < recordList.size(); ++i) {
+        TFileRecord* record = recordList.at(i);
+        delete record;
+    }
+    recordList.clear();
+    recordList.names.clear();
+
+    qDeleteAll(recordList.schemas);
+    recordList.schemas.clear();
+    recordList.clearIndex();
+
+    // records and nodes owning strings or lists were destroyed above
+    // plain nodes were skipped, their memory goes with the arena
+    recordList.arena.release();
+
+    memory.clear();
+    accounted = 0;
+}
+
+int TStream::recordCount()
+{
+    return recordList.count();
+}
+
+TFileRecord* TStream::getRecord(int n)
+{
+    if(n >= recordList.count()) return NULL;
+    return recordList.at(n);
+}
+
+qint32 TStream::associateReferences()
+{
+    QList<qint32> unresolved;
+    return associateReferences(unresolved);
+}
+
+qint32 TStream::associateReferences(QList<qint32>& unresolved)
+{
+    // find record with object id referenced by member
+    // within same stream
+    // each id not found is added once to unresolved
+    // returns first record not found or 0 on success
+
+    QList<TBinaryType*> btlist;
+    for (int i = 0; i < recordList.size(); ++i) {
+        TFileRecord* record = recordList.at(i);
+        record->getReferences(btlist);
+    }
+
+    QSet<qint32> missing;
+    qint32 result = 0;
+    for(int i=0; i<btlist.size(); i++) {
+        TBinaryType* b = btlist.at(i);
+        TFileRecord* testrec = recordList.find(b->refID);
+        if(testrec != NULL) {
+            b->refRecord = testrec;
+            testrec->isReferenced = true;
+        }
+        else if(!missing.contains(b->refID)) {
+            missing.insert(b->refID);
+            unresolved.append(b->refID);
+            if(result == 0) result = b->refID;
+        }
+    }
+
+    return result;
+}
+
+TClassColumns* TStream::getColumns(const QString& name)
+{
+    // columns of the class with this display name
+    qint32 id = recordList.names.find(name);
+    if(id < 0) return NULL;
+
+    QHash<qint32, TClassSchema*>::const_iterator it;
+    for(it = recordList.schemas.constBegin(); it != recordList.schemas.constEnd(); ++it) {
+        TClassSchema* schema = it.value();
+        if(schema->columns != NULL && schema->classInfo.displayNameID == id) return schema->columns;
+    }
+    return NULL;
+}
+
+TFileRecord* TStream::getClass(const QString& name)
+{
+    qint32 id = recordList.names.find(name);
+    if(id < 0) return NULL;
+
+    for (int i = 0; i < recordList.size(); ++i) {
+        TFileRecord* r = recordList.at(i);
+        if(r != NULL && !r->isReferenced) {
+            if(r->classInfo.displayNameID == id) {
+                return r;
+            }
+        }
+    }
+    return NULL;
+}
+
+
+// ==========================================
+// TDeserializer
+// ==========================================
+
+TDeserializer::TDeserializer()
+{
+
+}
+
+TDeserializer::~TDeserializer()
+{
+    clearList();
+}
+
+int TDeserializer::read(TBinaryInput& input)
+{
+    clearList();
+
+    char c;
+    if(!input.readChar(c)) {
+        return DESERIAL_FILE_READ_FAILED;
+    }
+
+    bool finished = false;
+    while(!finished) {
+
+        if(c != 0) {
+            return DESERIAL_NO_HEADER;
+        }
+
+        TStream* stream = new TStream();
+        streamList.append(stream);
+
+        int result = stream->read(input);
+        if(result != DESERIAL_OK) {
+            return result;
+        }
+
+        finished = (!input.readChar(c));
+    }
+
+    return DESERIAL_OK;
+}
+
+void TDeserializer::clearList()
+{
+    for (int i = 0; i < streamList.size(); ++i) {
+        TStream* stream = streamList.at(i);
+        delete stream;
+    }
+    streamList.clear();
+}
+
+qint32 TDeserializer::associateReferences()
+{
+    QList<qint32> unresolved;
+    return associateReferences(unresolved);
+}
+
+qint32 TDeserializer::associateReferences(QList<qint32>& unresolved)
+{
+    // find record with object id referenced by member
+    // every stream is done, unresolved has the ids not found in each
+    qint32 result = 0;
+    for (int i = 0; i < streamList.size(); ++i) {
+        qint32 r = streamList.at(i)->associateReferences(unresolved);
+        if(result == 0) result = r;
+    }
+    return result;
+}
+
+int TDeserializer::streamCount()
+{
+    return streamList.count();
+}
+
+qint64 TDeserializer::memoryUsed()
+{
+    qint64 total = 0;
+    for (int i = 0; i < streamList.size(); ++i) {
+        total += streamList.at(i)->memoryUsed();
+    }
+    return total;
+}
+
+TStream* TDeserializer::getStream(int n)
+{
+    if(n >= streamList.count()) return NULL;
+    return streamList.at(n);
+}
+
+TSearchType* TDeserializer::getObject(QStringList& path)
+{
+    return getObject(path, scratch);
+}
+
+TSearchType* TDeserializer::getObject(QStringList& path, TBinaryPrimitive& scratch)
+{
+    // 0:stream number
+    // 1:record class displayname
+    // 2:member name or index(number)
+    // ...:member name or index(number)
+    lastPath = path;
+
+    if(path.size() < 3) return NULL;
+
+    // stream
+    bool ok;
+    int s = path.at(0).toInt(&ok, 10);
+    if(!ok) return NULL;
+
+    TStream* stream = getStream(s);
+    if(stream == NULL) return NULL;
+
+    // class
+    TSearchType* result = stream->getClass(path.at(1));
+    if(result == NULL) return NULL;
+
+    for(int p=2; p<path.size(); p++) {
+        if(result->getColumnMember(p, path, scratch.value)) {
+            // a primitive, nothing below it
+            if(p != path.size() - 1) return NULL;
+            scratch.typeEnum = scratch.value.type;
+            return &scratch;
+        }
+
+        result = result->getMember(p, path);
+        if(result == NULL) return NULL;
+    }
+    return result;
+}
+
+void TDeserializer::getLastPath(QString& path)
+{
+    path = "";
+    for(int s=0; s<lastPath.length(); s++) {
+        if(s > 0) path += "/";
+        path += lastPath.at(s);
+    }
+}
+
+void TDeserializer::getErrorString(int error, QString& str)
+{
+    switch(error) {
+        case DESERIAL_OK: str = "Ok"; break;
+        case DESERIAL_FILE_OPEN_FAILED: str = "File open failed"; break;
+        case DESERIAL_FILE_READ_FAILED: str = "File read failed"; break;
+        case DESERIAL_NO_HEADER: str = "Header not found"; break;
+        case DESERIAL_UNKNOWN_RECORD: str = "Unknown record"; break;
+        case DESERIAL_RECORD_READ_FAILED: str = "Failed to read record"; break;
+        default: str = "Unknown error";
+    }
+}
+
+
+// ==========================================
+// TBinaryInput
+// ==========================================
+
+const char* TBinaryInput::readView(int count) {
+    if(count < 0) return NULL;
+    if(limit - cursor < count && !fill(count)) return NULL;
+
+    const char* result = cursor;
+    cursor += count;
+    return result;
+}
+
+bool TBinaryInput::readArray(void* buffer, int count, int size) {
+    // one transfer for the whole array instead of one read per element
+    // split into chunks so each readBytes count fits in an int
+    if(count < 0) return false;
+
+    char* p = (char*)buffer;
+    qint64 remaining = (qint64)count * size;
+    while(remaining > 0) {
+        int n = (int)qMin(remaining, (qint64)ARRAY_READ_CHUNK);
+        if(!readBytes(p, n)) return false;
+        p += n;
+        remaining -= n;
+    }
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    swapBytes(buffer, count, size);
+#endif
+    return true;
+}
+
+void swapBytes(void* data, int count, int size) {
+    // file data is little endian
+    switch(size) {
+    case 2: {
+        quint16* p = (quint16*)data;
+        for(int i=0; i<count; i++) p[i] = qbswap(p[i]);
+        break;
+    }
+    case 4: {
+        quint32* p = (quint32*)data;
+        for(int i=0; i<count; i++) p[i] = qbswap(p[i]);
+        break;
+    }
+    case 8: {
+        quint64* p = (quint64*)data;
+        for(int i=0; i<count; i++) p[i] = qbswap(p[i]);
+        break;
+    }
+    }
+}
+
+void normaliseBools(char* data, int count) {
+    // map every non zero byte to 1 so the bytes are valid bools
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    for(; i + 16 <= count; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        v = _mm_andnot_si128(_mm_cmpeq_epi8(v, zero), one);
+        _mm_storeu_si128((__m128i*)(data + i), v);
+    }
+#endif
+    for(; i<count; i++) {
+        data[i] = (data[i] != 0);
+    }
+}
+
+bool TBinaryInput::readVariableInt(qint32& result) {
+    // 7 bits per byte, high bit set if another byte follows
+    // names and most strings need one or two bytes
+    const uchar* p = (const uchar*)cursor;
+    int avail = limit - cursor;
+    if(avail >= 1 && p[0] < 0x80) {
+        result = p[0];
+        cursor += 1;
+        return true;
+    }
+    if(avail >= 2 && p[1] < 0x80) {
+        result = (p[0] & 0x7F) | (p[1] << 7);
+        cursor += 2;
+        return true;
+    }
+
+    quint32 value = 0;
+    for(int i=0; i<5; i++) {
+        quint8 c;
+        if(!readU8(c)) return false;
+
+        if(i == 4) {
+            // fifth byte holds the top 4 bits of a non-negative int32
+            if(c > 0x07) return false;
+        }
+
+        value |= (quint32)(c & 0x7F) << (i * 7);
+        if((c & 0x80) == 0) {
+            // last byte
+            result = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// true if no byte has the high bit set
+// checks a word at a time, names are almost always plain ASCII
+static bool isAscii(const char* data, int size) {
+    const char* end = data + size;
+    while(end - data >= (int)sizeof(quint64)) {
+        quint64 word;
+        memcpy(&word, data, sizeof(word));
+        if(word & Q_UINT64_C(0x8080808080808080)) return false;
+        data += sizeof(word);
+    }
+    quint8 bits = 0;
+    while(data < end) {
+        bits |= (quint8)*data++;
+    }
+    return (bits & 0x80) == 0;
+}
+
+void decodeString(const char* data, int size, QString& str) {
+    // latin1 is a plain widening copy, utf8 has to validate
+    if(isAscii(data, size)) {
+        str = QString::fromLatin1(data, size);
+    } else {
+        str = QString::fromUtf8(data, size);
+    }
+}
+
+bool TBinaryInput::readString(QString& str) {
+    qint32 strsize;
+    if(!readVariableInt(strsize)) return false;
+    if(strsize == 0) {
+        str = "";
+        return true;
+    }
+
+    // convert in place if the input holds the bytes
+    const char* view = readView(strsize);
+    if(view != NULL) {
+        decodeString(view, strsize, str);
+        return true;
+    }
+
+    // otherwise go through the scratch buffer which keeps its capacity
+    if(scratch.size() < strsize) {
+        scratch.resize(strsize);
+    }
+    if(!readBytes(scratch.data(), strsize)) return false;
+    decodeString(scratch.constData(), strsize, str);
+
+    return true;
+}
+
+bool TBinaryInput::readUtf8(QByteArray& bytes) {
+    qint32 strsize;
+    if(!readVariableInt(strsize)) return false;
+    if(strsize == 0) {
+        bytes.clear();
+        return true;
+    }
+
+    const char* view = readView(strsize);
+    if(view != NULL) {
+        if((flags & INPUT_PERSISTENT) && persistent()) {
+            // keep a reference to the input, no copy
+            // a windowed input refills the view, so it is always copied
+            bytes = QByteArray::fromRawData(view, strsize);
+        } else {
+            bytes = QByteArray(view, strsize);
+        }
+        return true;
+    }
+
+    bytes.resize(strsize);
+    return readBytes(bytes.data(), strsize);
+}
+
+bool TBinaryInput::readDecimal(TDecimal& value) {
+    // parsed from the view or scratch buffer without making a QString
+    qint32 strsize;
+    if(!readVariableInt(strsize)) return false;
+
+    const char* view = readView(strsize);
+    if(view == NULL) {
+        if(scratch.size() < strsize) {
+            scratch.resize(strsize);
+        }
+        if(!readBytes(scratch.data(), strsize)) return false;
+        view = scratch.constData();
+    }
+    return value.parse(view, strsize);
+}
+
+// bytes in the utf8 sequence starting with c, 0 if c can't start one
+static inline int utf8Length(quint8 c) {
+    if(c < 0x80) return 1;
+    if(c < 0xC0) return 0;
+    if(c < 0xE0) return 2;
+    if(c < 0xF0) return 3;
+    if(c < 0xF8) return 4;
+    return 0;
+}
+
+bool TBinaryInput::readChars(QString& str, int count) {
+    // count is in utf16 chars as written by BinaryWriter.Write(char[])
+    // a 4 byte sequence is a surrogate pair and counts as two
+    // the bytes are scanned in the window and decoded once at the end
+    // they are gathered in scratch only if the window has to be refilled
+    if(count < 0) return false;
+
+    const char* start = cursor;
+    int used = 0;
+    int units = 0;
+    while(units < count) {
+        const quint8* p = (const quint8*)cursor;
+        const quint8* end = (const quint8*)limit;
+        while(units < count && p < end) {
+#ifdef __SSE2__
+            // skip plain ASCII 16 bytes at a time
+            while(count - units >= 16 && end - p >= 16) {
+                __m128i v = _mm_loadu_si128((const __m128i*)p);
+                if(_mm_movemask_epi8(v) != 0) break;
+                p += 16;
+                units += 16;
+            }
+            if(units == count || p == end) break;
+#endif
+            int n = utf8Length(*p);
+            if(n == 0) return false;
+            if(end - p < n) break;
+            for(int i=1; i<n; i++) {
+                if((p[i] & 0xC0) != 0x80) return false;
+            }
+            p += n;
+            units += (n == 4) ? 2 : 1;
+        }
+        cursor = (const char*)p;
+        if(units >= count) break;
+
+        // the window ends before the next sequence does
+        // keep what was scanned, the refill moves the window
+        int scanned = cursor - start;
+        if(scratch.size() < used + scanned + 4) {
+            scratch.resize(used + scanned + 4 + scanned / 2);
+        }
+        if(scanned > 0) memcpy(scratch.data() + used, start, scanned);
+        used += scanned;
+
+        if(cursor < limit && fill(utf8Length(*(const quint8*)cursor))) {
+            start = cursor;
+            continue;
+        }
+        if(cursor == limit && fill(1)) {
+            start = cursor;
+            continue;
+        }
+
+        // no window, one sequence at a time from readBytes
+        char* seq = scratch.data() + used;
+        if(!readBytes(seq, 1)) return false;
+        int n = utf8Length(seq[0]);
+        if(n == 0) return false;
+        if(n > 1 && !readBytes(seq + 1, n - 1)) return false;
+        for(int i=1; i<n; i++) {
+            if((seq[i] & 0xC0) != 0x80) return false;
+        }
+        used += n;
+        units += (n == 4) ? 2 : 1;
+        start = cursor;
+    }
+
+    if(used == 0) {
+        decodeString(start, cursor - start, str);
+        return true;
+    }
+
+    int scanned = cursor - start;
+    if(scratch.size() < used + scanned) {
+        scratch.resize(used + scanned);
+    }
+    if(scanned > 0) memcpy(scratch.data() + used, start, scanned);
+    decodeString(scratch.constData(), used + scanned, str);
+    return true;
+}
+
+bool TBinaryInput::readStringWithCode(QString& str) {
+    char c; // 18 for string
+    if(!readChar(c) || c != 18) {
+        return false;
+    }
+
+    return readString(str);
+}
+
+bool TBinaryInput::readArrayOfValueWithCode(QList<TPrimitiveType*>& list, TArena* arena)
+{
+    qint32 length;
+    if(!readI32(length)) return false;
+
+    for(int i=0; i<length; i++) {
+        char c;
+        if(!readChar(c)) return false;
+
+        TPrimitiveType* p = getPrimitiveType(c, arena);
+        if(p == NULL) return false;
+
+        p->read(*this);
+        list.append(p);
+    }
+    return true;
+}
+
+// ==========================================
+// TFileInput
+// ==========================================
+
+TFileInput::TFileInput(QString& filename) : infile(filename)
+{
+
+}
+
+TFileInput::~TFileInput()
+{
+
+}
+
+bool TFileInput::open()
+{
+    return infile.open(QFile::ReadOnly);
+}
+
+bool TFileInput::readBytes(char* buffer, int count)
 {
-    for (int i = 0; i < recordList.size(); ++i) {
-        TFileRecord* record = recordList.at(i);
-        delete record;
-    }
-    recordList.clear();
+    return(infile.read(buffer, count) == count);
 }
 
-int TStream::recordCount()
+// ==========================================
+// TBufferedFileInput
+// ==========================================
+
+TBufferedFileInput::TBufferedFileInput(QString& filename, int blocksize) : infile(filename)
 {
-    return recordList.count();
+    blockSize = blocksize;
+    block = new char[blockSize];
 }
 
-TFileRecord* TStream::getRecord(int n)
+TBufferedFileInput::~TBufferedFileInput()
 {
-    if(n >= recordList.count()) return NULL;
-    return recordList.at(n);
+    delete[] block;
 }
 
-qint32 TStream::associateReferences()
+bool TBufferedFileInput::open()
 {
-    // find record with object id referenced by member
-    // within same stream
-    // returns record not found or 0 on success
+    cursor = block;
+    limit = block;
+    return infile.open(QFile::ReadOnly);
+}
 
-    QList<TBinaryType*> btlist;
-    for (int i = 0; i < recordList.size(); ++i) {
-        TFileRecord* record = recordList.at(i);
-        record->getReferences(btlist);
+bool TBufferedFileInput::readBytes(char* buffer, int count)
+{
+    int avail = limit - cursor;
+    if(count <= avail) {
+        memcpy(buffer, cursor, count);
+        cursor += count;
+        return true;
     }
 
-    for(int i=0; i<btlist.size(); i++) {
-        TBinaryType* b = btlist.at(i);
-        bool found = false;
-        for (int j = 0; j < recordList.size(); ++j) {
-            TFileRecord* testrec = recordList.at(j);
-            if(testrec->objectID == b->refID) {
-                b->refRecord = testrec;
-                testrec->isReferenced = true;
-                found = true;
-                break;
-            }
-        }
-        if(!found) return b->refID;
+    // use up the rest of the block
+    memcpy(buffer, cursor, avail);
+    cursor = limit;
+    buffer += avail;
+    count -= avail;
+
+    if(count >= blockSize) {
+        return(infile.read(buffer, count) == count);
     }
 
-    return 0;
+    if(!fill(count)) return false;
+    memcpy(buffer, cursor, count);
+    cursor += count;
+    return true;
 }
 
-TFileRecord* TStream::getClass(const QString& name)
+bool TBufferedFileInput::fill(int count)
 {
-    for (int i = 0; i < recordList.size(); ++i) {
-        TFileRecord* r = recordList.at(i);
-        if(r != NULL && !r->isReferenced) {
-            if(r->classInfo.displayName == name) {
-                return r;
-            }
-        }
+    if(count > blockSize) return false;
+
+    // move unread bytes to the start of the block
+    int avail = limit - cursor;
+    memmove(block, cursor, avail);
+    cursor = block;
+    limit = block + avail;
+
+    while(avail < count) {
+        qint64 n = infile.read(block + avail, blockSize - avail);
+        if(n <= 0) return false;
+        avail += n;
+        limit = block + avail;
     }
-    return NULL;
+    return true;
 }
 
-
 // ==========================================
-// TDeserializer
+// TPrefetchFileInput
 // ==========================================
 
-TDeserializer::TDeserializer()
+class TPrefetchFileInput::TPrefetchThread : public QThread
 {
+public:
+    TPrefetchFileInput* input;
 
-}
+    TPrefetchThread(TPrefetchFileInput* in) { input = in; }
+    void run() override { input->prefetch(); }
+};
 
-TDeserializer::~TDeserializer()
+TPrefetchFileInput::TPrefetchFileInput(QString& filename, int blocksize) : infile(filename)
 {
-    clearList();
+    blockSize = blocksize;
+    waitTime = 0;
+    thread = NULL;
+    blocks[0] = new char[2 * blockSize];
+    blocks[1] = new char[2 * blockSize];
+    current = blocks[1];
+    freeBlock = blocks[0];
+    readyBlock = NULL;
+    readyCount = 0;
+    stopping = false;
+    finished = false;
+}
+
+TPrefetchFileInput::~TPrefetchFileInput()
+{
+    if(thread != NULL) {
+        mutex.lock();
+        stopping = true;
+        changed.wakeAll();
+        mutex.unlock();
+        thread->wait();
+        delete thread;
+    }
+    delete[] blocks[0];
+    delete[] blocks[1];
 }
 
-int TDeserializer::read(TBinaryInput& input)
+bool TPrefetchFileInput::open()
 {
-    clearList();
+    if(!infile.open(QFile::ReadOnly)) return false;
 
-    char c;
-    if(!input.readBytes(&c, 1)) {
-        return DESERIAL_FILE_READ_FAILED;
-    }
+    cursor = current + blockSize;
+    limit = cursor;
 
-    bool finished = false;
-    while(!finished) {
+    thread = new TPrefetchThread(this);
+    thread->start();
+    return true;
+}
 
-        if(c != 0) {
-            return DESERIAL_NO_HEADER;
+void TPrefetchFileInput::prefetch()
+{
+    // worker thread
+    // fill the free block then pass it over as the ready block
+    while(true) {
+        mutex.lock();
+        while(freeBlock == NULL && !stopping) changed.wait(&mutex);
+        if(stopping) {
+            mutex.unlock();
+            return;
         }
+        char* block = freeBlock;
+        freeBlock = NULL;
+        mutex.unlock();
 
-        TStream* stream = new TStream();
-        streamList.append(stream);
+        qint64 n = infile.read(block + blockSize, blockSize);
 
-        int result = stream->read(input);
-        if(result != DESERIAL_OK) {
-            return result;
-        }
+        mutex.lock();
+        readyBlock = block;
+        readyCount = (int)n;
+        changed.wakeAll();
+        mutex.unlock();
 
-        finished = (!input.readBytes(&c, 1));
+        // end of file or error
+        if(n <= 0) return;
     }
+}
 
-    return DESERIAL_OK;
+bool TPrefetchFileInput::nextBlock()
+{
+    if(finished) return false;
+
+    mutex.lock();
+    if(readyBlock == NULL) {
+        QElapsedTimer timer;
+        timer.start();
+        while(readyBlock == NULL) changed.wait(&mutex);
+        waitTime += timer.nsecsElapsed();
+    }
+    char* block = readyBlock;
+    int count = readyCount;
+    readyBlock = NULL;
+    mutex.unlock();
+
+    if(count <= 0) {
+        finished = true;
+        return false;
+    }
+
+    // carry unread bytes over in front of the new data
+    int avail = limit - cursor;
+    char* start = block + blockSize - avail;
+    memcpy(start, cursor, avail);
+
+    // the old block can now be refilled
+    mutex.lock();
+    freeBlock = current;
+    changed.wakeAll();
+    mutex.unlock();
+
+    current = block;
+    cursor = start;
+    limit = block + blockSize + count;
+    return true;
 }
 
-void TDeserializer::clearList()
+bool TPrefetchFileInput::readBytes(char* buffer, int count)
 {
-    for (int i = 0; i < streamList.size(); ++i) {
-        TStream* stream = streamList.at(i);
-        delete stream;
+    while(count > limit - cursor) {
+        int avail = limit - cursor;
+        memcpy(buffer, cursor, avail);
+        cursor = limit;
+        buffer += avail;
+        count -= avail;
+        if(!nextBlock()) return false;
     }
-    streamList.clear();
+
+    memcpy(buffer, cursor, count);
+    cursor += count;
+    return true;
 }
 
-qint32 TDeserializer::associateReferences()
+bool TPrefetchFileInput::fill(int count)
 {
-    // find record with object id referenced by member
-    for (int i = 0; i < streamList.size(); ++i) {
-        qint32 result = streamList.at(i)->associateReferences();
-        if(result != 0) return result;
+    if(count > blockSize) return false;
+
+    while(limit - cursor < count) {
+        if(!nextBlock()) return false;
     }
-    return 0;
+    return true;
 }
 
-int TDeserializer::streamCount()
+// ==========================================
+// TGzipFileInput
+// ==========================================
+
+TGzipFileInput::TGzipFileInput(QString& filename, int blocksize) : infile(filename)
 {
-    return streamList.count();
+    blockSize = blocksize;
+    inBlock = new char[blockSize];
+    block = new char[blockSize];
+    zstream = NULL;
+    finished = false;
+    memberEnd = false;
 }
 
-TStream* TDeserializer::getStream(int n)
+TGzipFileInput::~TGzipFileInput()
 {
-    if(n >= streamList.count()) return NULL;
-    return streamList.at(n);
+    if(zstream != NULL) {
+        inflateEnd(zstream);
+        delete zstream;
+    }
+    delete[] inBlock;
+    delete[] block;
 }
 
-TSearchType* TDeserializer::getObject(QStringList& path)
+bool TGzipFileInput::open()
 {
-    // 0:stream number
-    // 1:record class displayname
-    // 2:member name or index(number)
-    // ...:member name or index(number)
-    lastPath = path;
+    if(!infile.open(QFile::ReadOnly)) return false;
 
-    if(path.size() < 3) return NULL;
+    zstream = new z_stream;
+    memset(zstream, 0, sizeof(z_stream));
 
-    // stream
-    bool ok;
-    int s = path.at(0).toInt(&ok, 10);
-    if(!ok) return NULL;
+    // 32 - detect gzip or zlib header
+    if(inflateInit2(zstream, 15 + 32) != Z_OK) {
+        delete zstream;
+        zstream = NULL;
+        return false;
+    }
 
-    TStream* stream = getStream(s);
-    if(stream == NULL) return NULL;
+    cursor = block;
+    limit = block;
+    return true;
+}
 
-    // class
-    TSearchType* result = stream->getClass(path.at(1));
-    if(result == NULL) return NULL;
+int TGzipFileInput::inflateBlock(char* buffer, int size)
+{
+    // returns bytes inflated, 0 at end of data or -1 on error
+    // the file may only end between members, not inside one
+
+    zstream->next_out = (Bytef*)buffer;
+    zstream->avail_out = size;
+
+    while(zstream->avail_out == (uInt)size && !finished) {
+        if(zstream->avail_in == 0) {
+            qint64 n = infile.read(inBlock, blockSize);
+            if(n < 0) return -1;
+            if(n == 0) {
+                if(!memberEnd) return -1;
+                finished = true;
+                break;
+            }
+            zstream->next_in = (Bytef*)inBlock;
+            zstream->avail_in = (uInt)n;
+        }
 
-    for(int p=2; p<path.size(); p++) {
-        result = result->getMember(p, path);
-        if(result == NULL) return NULL;
+        int result = inflate(zstream, Z_NO_FLUSH);
+        if(result == Z_STREAM_END) {
+            // gzip files can hold several members
+            if(inflateReset(zstream) != Z_OK) return -1;
+            memberEnd = true;
+        }
+        else if(result == Z_OK) {
+            memberEnd = false;
+        }
+        else if(result != Z_BUF_ERROR) {
+            return -1;
+        }
     }
-    return result;
+
+    return size - zstream->avail_out;
 }
 
-void TDeserializer::getLastPath(QString& path)
+bool TGzipFileInput::readBytes(char* buffer, int count)
 {
-    path = "";
-    for(int s=0; s<lastPath.length(); s++) {
-        if(s > 0) path += "/";
-        path += lastPath.at(s);
+    while(count > limit - cursor) {
+        int avail = limit - cursor;
+        memcpy(buffer, cursor, avail);
+        cursor = limit;
+        buffer += avail;
+        count -= avail;
+        if(!fill(qMin(count, blockSize))) return false;
     }
+
+    memcpy(buffer, cursor, count);
+    cursor += count;
+    return true;
 }
 
-void TDeserializer::getErrorString(int error, QString& str)
+bool TGzipFileInput::fill(int count)
 {
-    switch(error) {
-        case DESERIAL_OK: str = "Ok"; break;
-        case DESERIAL_FILE_OPEN_FAILED: str = "File open failed"; break;
-        case DESERIAL_FILE_READ_FAILED: str = "File read failed"; break;
-        case DESERIAL_NO_HEADER: str = "Header not found"; break;
-        case DESERIAL_UNKNOWN_RECORD: str = "Unknown record"; break;
-        case DESERIAL_RECORD_READ_FAILED: str = "Failed to read record"; break;
-        default: str = "Unknown error";
+    if(zstream == NULL || count > blockSize) return false;
+
+    // move unread bytes to the start of the block
+    int avail = limit - cursor;
+    memmove(block, cursor, avail);
+    cursor = block;
+    limit = block + avail;
+
+    while(avail < count) {
+        int n = inflateBlock(block + avail, blockSize - avail);
+        if(n <= 0) return false;
+        avail += n;
+        limit = block + avail;
     }
+    return true;
 }
 
-
 // ==========================================
-// TBinaryInput
+// TMappedFileInput
 // ==========================================
 
-int TBinaryInput::readVariableInt() {
-    int result = 0;
-    for(int i=0; i<5; i++) {
-        char c;
-        if(!readBytes(&c, 1)) {
-            return result;
-        }
-        result += ((c & 0x7F) << (i * 7));
-        if((c & 0x80) == 0) {
-            // last byte
-            break;
-        }
-    }
-    return result;
+TMappedFileInput::TMappedFileInput(QString& filename) : infile(filename)
+{
+    data = NULL;
+    size = 0;
 }
 
-bool TBinaryInput::readString(QString& str) {
-    int strsize = readVariableInt();
-    if(strsize == 0) {
-        str = "";
-        return true;
-    }
-
-    char* buffer = new char[strsize];
-    if(!readBytes(buffer, strsize)) return false;
-    str = QString::fromUtf8(buffer, strsize);
-    delete[] buffer;
-
-    return true;
+TMappedFileInput::~TMappedFileInput()
+{
+    if(data != NULL) infile.unmap((uchar*)data);
 }
 
-bool TBinaryInput::readStringWithCode(QString& str) {
-    char c; // 18 for string
-    if(!readBytes(&c, 1) || c != 18) {
-        return false;
-    }
+bool TMappedFileInput::open()
+{
+    if(!infile.open(QFile::ReadOnly)) return false;
 
-    int strsize = readVariableInt();
+    size = infile.size();
+    if(size == 0) return true;
 
-    char* buffer = new char[strsize];
-    if(!readBytes(buffer, strsize)) return false;
-    str = QString::fromUtf8(buffer, strsize);
-    delete[] buffer;
+    data = (const char*)infile.map(0, size);
+    if(data == NULL) return false;
 
+    // the window is the whole file
+    cursor = data;
+    limit = data + size;
     return true;
 }
 
-bool TBinaryInput::readArrayOfValueWithCode(QList<TPrimitiveType*>& list)
+bool TMappedFileInput::readBytes(char* buffer, int count)
 {
-    qint32 length;
-    if(!readBytes((char*)&length, 4)) return false;
-
-    for(int i=0; i<length; i++) {
-        char c;
-        if(!readBytes(&c, 1)) return false;
-
-        TPrimitiveType* p = getPrimitiveType(c);
-        if(p == NULL) return false;
-
-        p->read(*this);
-        list.append(p);
-    }
+    if(count < 0 || count > limit - cursor) return false;
+    memcpy(buffer, cursor, count);
+    cursor += count;
     return true;
 }
 
 // ==========================================
-// TFileInput
+// TMemoryInput
 // ==========================================
 
-TFileInput::TFileInput(QString& filename) : infile(filename)
-{
-
-}
-
-TFileInput::~TFileInput()
+TMemoryInput::TMemoryInput(const QByteArray& buffer) : bytes(buffer)
 {
-
+    data = bytes.constData();
+    size = bytes.size();
+    cursor = data;
+    limit = data + size;
 }
 
-bool TFileInput::open()
+TMemoryInput::TMemoryInput(const char* buffer, qint64 length)
 {
-    return infile.open(QFile::ReadOnly);
+    data = buffer;
+    size = length;
+    cursor = data;
+    limit = data + size;
 }
 
-bool TFileInput::readBytes(char* buffer, int count)
+bool TMemoryInput::readBytes(char* buffer, int count)
 {
-    return(infile.read(buffer, count) == count);
+    if(count < 0 || count > limit - cursor) return false;
+    memcpy(buffer, cursor, count);
+    cursor += count;
+    return true;
 }
 
 // ==========================================
@@ -2821,224 +4795,358 @@ bool TFileInputLog::readBytes(char* buffer, int count)
     return true;
 }
 
+// ==========================================
+// TFileInputTrace
+// ==========================================
+
+class TFileInputTrace::TTraceWriter : public QThread
+{
+public:
+    TFileInputTrace* input;
+
+    TTraceWriter(TFileInputTrace* in) { input = in; }
+    void run() override { input->flush(); }
+};
+
+TFileInputTrace::TFileInputTrace(QString& filename, QString& tracename, int ringsize)
+    : infile(filename), tracefile(tracename)
+{
+    byteCount = 0;
+    writer = NULL;
+
+    // even size so the ring splits into two halves
+    if(ringsize < 2) ringsize = 2;
+    ringSize = (ringsize + 1) & ~1;
+    ring = new TTraceEntry[ringSize];
+    memset(ring, 0, ringSize * sizeof(TTraceEntry));
+    head = 0;
+    published = 0;
+    tail = 0;
+    stopping = false;
+
+    record = -1;
+    recordType = -1;
+    typePending = false;
+}
+
+TFileInputTrace::~TFileInputTrace()
+{
+    if(writer != NULL) {
+        mutex.lock();
+        published = head;
+        stopping = true;
+        changed.wakeAll();
+        mutex.unlock();
+        writer->wait();
+        delete writer;
+    }
+    tracefile.close();
+    delete[] ring;
+}
+
+bool TFileInputTrace::open()
+{
+    if(!infile.open(QFile::ReadOnly)) return false;
+    if(!tracefile.open(QIODevice::WriteOnly)) return false;
+
+    writer = new TTraceWriter(this);
+    writer->start();
+    return true;
+}
+
+bool TFileInputTrace::readBytes(char* buffer, int count)
+{
+    if(!(infile.read(buffer, count) == count)) return false;
+
+    TTraceEntry& entry = ring[head % ringSize];
+    entry.offset = byteCount;
+    entry.length = count;
+    entry.record = record;
+    entry.recordType = recordType;
+    byteCount += count;
+    head++;
+
+    if(!typePending && head % (ringSize / 2) == 0) publish();
+    return true;
+}
+
+void TFileInputTrace::beginRecord()
+{
+    record++;
+    recordType = -1;
+    typePending = true;
+}
+
+void TFileInputTrace::setRecordType(char type)
+{
+    // the code byte was the last read, not yet passed to the writer
+    recordType = type;
+    if(head > 0 && ring[(head - 1) % ringSize].record == record) {
+        ring[(head - 1) % ringSize].recordType = type;
+    }
+    typePending = false;
+
+    if(head > 0 && head % (ringSize / 2) == 0) publish();
+}
+
+void TFileInputTrace::publish()
+{
+    // pass the half just filled to the writer
+    // and wait if it has not finished with the other half
+    mutex.lock();
+    published = head;
+    changed.wakeAll();
+    while(head - tail > ringSize / 2) changed.wait(&mutex);
+    mutex.unlock();
+}
+
+void TFileInputTrace::flush()
+{
+    // writer thread
+    while(true) {
+        mutex.lock();
+        while(tail == published && !stopping) changed.wait(&mutex);
+        if(tail == published) {
+            mutex.unlock();
+            return;
+        }
+        qint64 end = published;
+        mutex.unlock();
+
+        while(tail < end) {
+            // up to the end of the ring at most
+            int start = tail % ringSize;
+            int count = qMin(end - tail, (qint64)(ringSize - start));
+            tracefile.write((const char*)&(ring[start]), count * sizeof(TTraceEntry));
+
+            mutex.lock();
+            tail += count;
+            changed.wakeAll();
+            mutex.unlock();
+        }
+    }
+}
+
 // ==========================================
 // ==========================================
 
-TFileRecord* getRecordType(char code) {
+TFileRecord* getRecordType(char code, TArena* arena) {
 
     TFileRecord* record = NULL;
 
     switch(code) {
         case 0:
-            record = (TFileRecord*)new TSerializedStreamHeader();
+            record = (TFileRecord*)new(arena) TSerializedStreamHeader();
             break;
         case 1:
-            record = (TFileRecord*)new TClassWithId();
+            record = (TFileRecord*)new(arena) TClassWithId();
             break;
         case 2:
-            record = (TFileRecord*)new TSystemClassWithMembers();
+            record = (TFileRecord*)new(arena) TSystemClassWithMembers();
             break;
         case 3:
-            record = (TFileRecord*)new TClassWithMembers();
+            record = (TFileRecord*)new(arena) TClassWithMembers();
             break;
         case 4:
-            record = (TFileRecord*)new TSystemClassWithMembersAndTypes();
+            record = (TFileRecord*)new(arena) TSystemClassWithMembersAndTypes();
             break;
         case 5:
-            record = (TFileRecord*)new TClassWithMembersAndTypes();
+            record = (TFileRecord*)new(arena) TClassWithMembersAndTypes();
             break;
         case 6:
-            record = (TFileRecord*)new TBinaryObjectString();
+            record = (TFileRecord*)new(arena) TBinaryObjectString();
             break;
         case 7:
-            record = (TFileRecord*)new TBinaryArray();
+            record = (TFileRecord*)new(arena) TBinaryArray();
             break;
         case 8:
-            record = (TFileRecord*)new TMemberPrimitiveTyped();
+            record = (TFileRecord*)new(arena) TMemberPrimitiveTyped();
             break;
         case 9:
-            record = (TFileRecord*)new TMemberReference();
+            record = (TFileRecord*)new(arena) TMemberReference();
             break;
         case 10:
-            record = (TFileRecord*)new TObjectNull();
+            record = (TFileRecord*)new(arena) TObjectNull();
             break;
         case 11:
-            record = (TFileRecord*)new TMessageEnd();
+            record = (TFileRecord*)new(arena) TMessageEnd();
             break;
         case 12:
-            record = (TFileRecord*)new TBinaryLibrary();
+            record = (TFileRecord*)new(arena) TBinaryLibrary();
             break;
         case 13:
-            record = (TFileRecord*)new TObjectNullMultiple256();
+            record = (TFileRecord*)new(arena) TObjectNullMultiple256();
             break;
         case 14:
-            record = (TFileRecord*)new TObjectNullMultiple();
+            record = (TFileRecord*)new(arena) TObjectNullMultiple();
             break;
         case 15:
-            record = (TFileRecord*)new TArraySinglePrimitive();
+            record = (TFileRecord*)new(arena) TArraySinglePrimitive();
             break;
         case 16:
-            record = (TFileRecord*)new TArraySingleObject();
+            record = (TFileRecord*)new(arena) TArraySingleObject();
             break;
         case 17:
-            record = (TFileRecord*)new TArraySingleString();
+            record = (TFileRecord*)new(arena) TArraySingleString();
             break;
         case 21:
-            record = (TFileRecord*)new TMethodCall();
+            record = (TFileRecord*)new(arena) TMethodCall();
             break;
         case 22:
-            record = (TFileRecord*)new TMethodReturn();
+            record = (TFileRecord*)new(arena) TMethodReturn();
             break;
     }
     if(record != NULL) record->type = code;
     return record;
 }
 
-TBinaryType* getBinaryType(char code) {
+TBinaryType* getBinaryType(char code, TArena* arena) {
 
     TBinaryType* result = NULL;
     switch(code) {
         case 0:
-            result = new TBinaryPrimitive();
+            result = new(arena) TBinaryPrimitive();
             break;
         case 1:
-            result = new TBinaryString();
+            result = new(arena) TBinaryString();
             break;
         case 2:
-            result = new TBinaryObject();
+            result = new(arena) TBinaryObject();
             break;
         case 3:
-            result = new TBinarySystemClass();
+            result = new(arena) TBinarySystemClass();
             break;
         case 4:
-            result = new TBinaryClass();
+            result = new(arena) TBinaryClass();
             break;
         case 5:
-            result = new TBinaryObjectArray();
+            result = new(arena) TBinaryObjectArray();
             break;
         case 6:
-            result = new TBinaryStringArray();
+            result = new(arena) TBinaryStringArray();
             break;
         case 7:
-            result = new TBinaryPrimitiveArray();
+            result = new(arena) TBinaryPrimitiveArray();
             break;
     }
     return result;
 }
 
-TPrimitiveType* getPrimitiveType(char code) {
+TPrimitiveType* getPrimitiveType(char code, TArena* arena) {
 
     TPrimitiveType* result = NULL;
     switch(code) {
         case 1:
-            result = new TPrimitiveBoolean();
+            result = new(arena) TPrimitiveBoolean();
             break;
         case 2:
-            result = new TPrimitiveByte();
+            result = new(arena) TPrimitiveByte();
             break;
         case 3:
-            result = new TPrimitiveChar();
+            result = new(arena) TPrimitiveChar();
             break;
         case 5:
-            result = new TPrimitiveDecimal();
+            result = new(arena) TPrimitiveDecimal();
             break;
         case 6:
-            result = new TPrimitiveDouble();
+            result = new(arena) TPrimitiveDouble();
             break;
         case 7:
-            result = new TPrimitiveInt16();
+            result = new(arena) TPrimitiveInt16();
             break;
         case 8:
-            result = new TPrimitiveInt32();
+            result = new(arena) TPrimitiveInt32();
             break;
         case 9:
-            result = new TPrimitiveInt64();
+            result = new(arena) TPrimitiveInt64();
             break;
         case 10:
-            result = new TPrimitiveSByte();
+            result = new(arena) TPrimitiveSByte();
             break;
         case 11:
-            result = new TPrimitiveSingle();
+            result = new(arena) TPrimitiveSingle();
             break;
         case 12:
-            result = new TPrimitiveTimeSpan();
+            result = new(arena) TPrimitiveTimeSpan();
             break;
         case 13:
-            result = new TPrimitiveDateTime();
+            result = new(arena) TPrimitiveDateTime();
             break;
         case 14:
-            result = new TPrimitiveUInt16();
+            result = new(arena) TPrimitiveUInt16();
             break;
         case 15:
-            result = new TPrimitiveUInt32();
+            result = new(arena) TPrimitiveUInt32();
             break;
         case 16:
-            result = new TPrimitiveUInt64();
+            result = new(arena) TPrimitiveUInt64();
             break;
         case 17:
-            result = new TPrimitiveNull();
+            result = new(arena) TPrimitiveNull();
             break;
         case 18:
-            result = new TPrimitiveString();
+            result = new(arena) TPrimitiveString();
             break;
     }
     return result;
 }
 
-TPrimitiveType *getArrayType(char code, int len) {
+TPrimitiveType *getArrayType(char code, int len, TArena* arena) {
+
+    if(len < 0) return NULL;
 
     TPrimitiveType* result = NULL;
     switch(code) {
         case 1:
-            result = new TArrayBoolean(len);
+            result = new(arena) TArrayBoolean(len);
             break;
         case 2:
-            result = new TArrayByte(len);
+            result = new(arena) TArrayByte(len);
             break;
         case 3:
-            result = new TArrayChar(len);
+            result = new(arena) TArrayChar(len);
             break;
         case 5:
-            result = new TArrayDecimal(len);
+            result = new(arena) TArrayDecimal(len);
             break;
         case 6:
-            result = new TArrayDouble(len);
+            result = new(arena) TArrayDouble(len);
             break;
         case 7:
-            result = new TArrayInt16(len);
+            result = new(arena) TArrayInt16(len);
             break;
         case 8:
-            result = new TArrayInt32(len);
+            result = new(arena) TArrayInt32(len);
             break;
         case 9:
-            result = new TArrayInt64(len);
+            result = new(arena) TArrayInt64(len);
             break;
         case 10:
-            result = new TArraySByte(len);
+            result = new(arena) TArraySByte(len);
             break;
         case 11:
-            result = new TArraySingle(len);
+            result = new(arena) TArraySingle(len);
             break;
         case 12:
-            result = new TArrayTimeSpan(len);
+            result = new(arena) TArrayTimeSpan(len);
             break;
         case 13:
-            result = new TArrayDateTime(len);
+            result = new(arena) TArrayDateTime(len);
             break;
         case 14:
-            result = new TArrayUInt16(len);
+            result = new(arena) TArrayUInt16(len);
             break;
         case 15:
-            result = new TArrayUInt32(len);
+            result = new(arena) TArrayUInt32(len);
             break;
         case 16:
-            result = new TArrayUInt64(len);
+            result = new(arena) TArrayUInt64(len);
             break;
         case 17:
-            result = new TArrayNull(len);
+            result = new(arena) TArrayNull(len);
             break;
         case 18:
-            result = new TArrayString(len);
+            result = new(arena) TArrayString(len);
             break;
     }
     return result;
@@ -3051,12 +5159,16 @@ void indentOutput(QTextStream& outstr, int indent)
     }
 }
 
-TFileRecord* getRecord(qint32 id, QList<TFileRecord*>& recordList)
+TClassSchema* addSchema(TFileRecord* record, TBinaryInput& input, TRecordList& recordList)
 {
-    for(int i=0; i<recordList.length(); i++) {
-        TFileRecord* record = recordList.at(i);
-        if(record->objectID == id) return record;
-    }
-    return NULL;
+    // read the member types of a class record into a new schema
+    // a second class record with the same objectID is not valid
+    if(recordList.schemas.contains(record->objectID)) return NULL;
+
+    TClassSchema* schema = new TClassSchema();
+    recordList.schemas.insert(record->objectID, schema);
+
+    if(!schema->read(input, record->classInfo, &recordList.arena)) return NULL;
+    return schema;
 }
 
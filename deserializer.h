@@ -6,6 +6,11 @@
 #include <QDateTime>
 #include <QFile>
 #include <QHash>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+
+struct z_stream_s;
 
 class TBinaryType;
 class TPrimitiveType;
@@ -13,6 +18,9 @@ class TArraySinglePrimitive;
 class TFileRecord;
 class TBinaryInput;
 class TBinaryObject;
+class TBinaryPrimitive;
+class TClassColumns;
+class TClassSchema;
 
 #define ARRAY_SINGLE 0
 #define ARRAY_JAGGED 1
@@ -47,6 +55,148 @@ class TBinaryObject;
 #define MAX_INDENT 20
 #define MAX_ARRAY_PRINT_SIZE 20
 
+// ==========================================
+// Arena
+// ==========================================
+
+#define ARENA_BLOCK_SIZE 65536
+
+class TArena
+{
+public:
+    // bump allocator for the nodes of one stream
+    // memory is only given back all at once by release
+
+    TArena();
+    ~TArena();
+    void* allocate(size_t size);
+    void release();
+    qint64 usedBytes() { return used; }
+    qint64 reservedBytes() { return reserved; }
+
+private:
+    QList<char*> blocks;
+    char* pos;
+    char* end;
+    qint64 used;
+    qint64 reserved;
+
+    Q_DISABLE_COPY(TArena)
+};
+
+class TArenaObject
+{
+public:
+    // base of the node classes so they can be placed with new(arena)
+    // a NULL arena allocates on the heap as usual
+    // a tag in front of each node tells delete whether to free it
+    // and holds the size of the node
+    // nodes need no more than 8 byte alignment
+    // an arena node that owns nothing is marked plain once read
+    // destroy leaves those to the arena without running their destructor
+
+    static void* operator new(size_t size);
+    static void* operator new(size_t size, TArena* arena);
+    static void operator delete(void* p);
+    static void operator delete(void* p, TArena* arena);
+    static qint64 nodeSize(const void* p);
+    static bool isPlain(const void* p);
+
+    template<typename T> static void destroy(T* p) {
+        if(p != NULL && !isPlain(p)) delete p;
+    }
+
+    // only for nodes made with new, heap nodes stay as they are
+    void setPlain(bool plain);
+};
+
+// ==========================================
+// NameTable
+// ==========================================
+
+class TNameTable
+{
+public:
+    // one copy of each class and member name in a stream
+    // records refer to names by id
+
+    TNameTable() { bytes = 0; }
+    qint32 intern(const QString& str);
+    qint32 find(const QString& str);
+    QString name(qint32 id);
+    int count();
+    void clear();
+    qint64 memorySize() { return bytes; }
+
+private:
+    QVector<QString> names;
+    QHash<QString, qint32> ids;
+    qint64 bytes;
+};
+
+// ==========================================
+// RecordList
+// ==========================================
+
+class TRecordList : public QList<TFileRecord*>
+{
+public:
+    // records of one stream and the names they share
+    // the records and their members are allocated in arena
+    // schema of each class with types, by objectID of its class record
+    // the first record with each objectID is indexed, see find
+    // denseIds by objectID for the small positive ids files use
+    // ids for the rest, so one large id does not size the vector
+    TNameTable names;
+    TArena arena;
+    QHash<qint32, TClassSchema*> schemas;
+    QVector<TFileRecord*> denseIds;
+    QHash<qint32, TFileRecord*> ids;
+    int indexed;
+
+    TRecordList() { indexed = 0; }
+    void updateIndex();
+    TFileRecord* find(qint32 id);
+    void clearIndex();
+
+private:
+    TFileRecord* findIndexed(qint32 id);
+};
+
+// ==========================================
+// MemoryStats
+// ==========================================
+
+class TArrayMemory
+{
+public:
+    qint32 objectID;
+    char typeEnum;
+    qint32 length;
+    qint64 bytes;
+};
+
+class TMemoryStats
+{
+public:
+    // bytes held by the records of a stream, added up as they are read
+    // a record counts its node, members and buffers, not the records nested in it
+    // byClass is by displayNameID, ClassWithId under the name of its class
+    // overhead is the name table, the record list and unused arena space
+    // allocator headers are not included
+
+    qint64 total;
+    qint64 overhead;
+    qint64 byType[23];
+    QHash<qint32, qint64> byClass;
+    QVector<TArrayMemory> arrays;
+
+    TMemoryStats() { clear(); }
+    void add(TFileRecord* record);
+    void setOverhead(qint64 bytes);
+    void clear();
+};
+
 // ==========================================
 // ClassInfo
 // ==========================================
@@ -55,25 +205,248 @@ class TClassInfo
 {
 public:
     qint32 objectID;
-    QString name;
-    QString displayName;
-    QList<QString> memberNames;
+    qint32 nameID;
+    qint32 displayNameID;
+    QVector<qint32> memberIDs;
+    TNameTable* names;
 
-    bool read(TBinaryInput& input);
+    TClassInfo();
+    bool read(TBinaryInput& input, TNameTable& table);
     void write(QTextStream& outstr, int indent);
+    void setName(TNameTable& table, const QString& str);
+
+    QString name();
+    QString displayName();
+    int memberCount() { return memberIDs.count(); }
+    QString memberName(int i);
+    int memberIndex(const QString& str);
+};
+
+// ==========================================
+// Decimal
+// ==========================================
+
+class TDecimal
+{
+public:
+    // System.Decimal, in file as its invariant culture string
+    // value is mantissa / 10^scale, negated if negative
+    // the 96 bit mantissa is held in three 32 bit words
+
+    quint32 lo;
+    quint32 mid;
+    quint32 hi;
+    quint8 scale;
+    bool negative;
+
+    TDecimal();
+    bool parse(const char* str, int size);
+    double toDouble() const;
+    QString toString() const;
+
+private:
+    bool mulAdd(quint32 digit);
+};
+
+// ==========================================
+// DateTime and TimeSpan
+// ==========================================
+
+// ticks from 1 jan 0001 to 1 jan 1970
+#define DATETIME_EPOCH_TICKS Q_INT64_C(621355968000000000)
+
+class TDateTimeValue
+{
+public:
+    // as in file, 62 bit ticks of 100 nanoseconds since 1 jan 0001
+    // and the DateTimeKind in the top 2 bits: 0 none, 1 utc, 2 local
+
+    quint64 raw;
+
+    qint64 ticks() const { return (qint64)(raw & Q_UINT64_C(0x3fffffffffffffff)); }
+    int kind() const { return (int)(raw >> 62); }
+    qint64 toMSecsSinceEpoch() const;
+    QDateTime toDateTime() const;
+};
+
+class TTimeSpanValue
+{
+public:
+    // signed ticks of 100 nanoseconds
+    qint64 ticks;
+};
+
+// whole array conversions
+// nanoseconds overflow outside the years 1677 to 2262
+void dateTimeToMSecs(const TDateTimeValue* values, qint64* result, int count);
+void dateTimeToNSecs(const TDateTimeValue* values, qint64* result, int count);
+void timeSpanToMSecs(const TTimeSpanValue* values, qint64* result, int count);
+void timeSpanToNSecs(const TTimeSpanValue* values, qint64* result, int count);
+
+// ==========================================
+// Value
+// ==========================================
+
+class TValue
+{
+public:
+    // a single primitive held in place, type is the PrimitiveTypeEnumeration
+    // fixed size types are kept in the 8 byte payload
+    // char, string and decimal hang off the payload and belong to the value
+
+    quint8 type;
+    union {
+        bool b;
+        qint64 i;
+        quint64 u;
+        double d;
+        float f;
+        QString* str;
+        TDecimal* decimal;
+    };
+
+    TValue();
+    ~TValue();
+    static bool isValidType(char code);
+    static int fixedSize(char code);
+    static bool readFixed(TBinaryInput& input, char code, char* data);
+    bool read(TBinaryInput& input, char code);
+    void load(char code, const char* data);
+    void store(char* data) const;
+    void write(QTextStream& outstr) const;
+    void writeType(QTextStream& outstr) const;
+    qint64 heapSize() const;
+
+    bool getBool(bool& result) const;
+    bool getInt(qint64& result) const;
+    bool getUnsigned(quint64& result) const;
+    bool getDouble(double& result) const;
+    bool getFloat(float& result) const;
+    bool getString(QString& result) const;
+    bool getDateTime(QDateTime& result) const;
+    bool getDecimal(TDecimal& result) const;
+
+private:
+    void clear();
+    Q_DISABLE_COPY(TValue)
+};
+
+// ==========================================
+// ClassSchema
+// ==========================================
+
+class TClassSchema
+{
+public:
+    // layout of a class with types, read with its class record
+    // names, member types and their additional info
+    // shared by the class record and its ClassWithId records, which
+    // clone types to hold their values and leave the schema unchanged
+
+    TClassInfo classInfo;
+    QList<TBinaryType*> types;
+    TClassColumns* columns;
+
+    TClassSchema();
+    ~TClassSchema();
+    bool read(TBinaryInput& input, TClassInfo& info, TArena* arena);
+    void cloneTypes(QList<TBinaryType*>& list, TArena* arena);
+    qint64 memorySize();
+};
+
+// ==========================================
+// ClassColumns
+// ==========================================
+
+class TColumn
+{
+public:
+    // one member of every instance of a class, in host byte order
+    // size 0 if the member is not a fixed size primitive
+    char typeEnum;
+    int size;
+    QByteArray data;
+
+    TColumn() { typeEnum = 0; size = 0; }
+};
+
+class TClassColumns
+{
+public:
+    // fixed size primitive members of the objects sharing one schema
+    // row 0 is the class record itself, then each ClassWithId as read
+    // the other members stay in the memberList of each object
+    // slots maps a member index to its place in that memberList, -1 for a column
+    // rowSize is the bytes of one row over all columns
+
+    TClassInfo classInfo;
+    QVector<TColumn> columns;
+    QVector<int> slots;
+    int rows;
+    int rowSize;
+
+    TClassColumns(TClassSchema* schema);
+    bool hasColumns();
+    bool isColumn(int member) { return columns.at(member).size > 0; }
+    int addRow();
+    bool readValue(TBinaryInput& input, int member, int row);
+    void storeRow(int row, TFileRecord* record);
+    void getValue(int member, int row, TValue& value);
+
+    // whole column as a typed span, T must have the size of the member type
+    // valid until the next object of the class is read
+    template<typename T> bool getColumn(const QString& member, const T** values, int& count) {
+        int i = classInfo.memberIndex(member);
+        if(i < 0 || i >= columns.count()) return false;
+        const TColumn& c = columns.at(i);
+        if(c.size != (int)sizeof(T)) return false;
+        *values = (const T*)c.data.constData();
+        count = rows;
+        return true;
+    }
+};
+
+// ==========================================
+// ElementRuns
+// ==========================================
+
+class TRun
+{
+public:
+    qint32 start;
+    qint32 count;
+    qint32 slot;
+};
+
+class TElementRuns
+{
+public:
+    // elements of an array that are not null, as runs of consecutive elements
+    // those elements are stored in slots in order, nulls take no space
+    // element start + n of a run is in slot + n
+
+    QVector<TRun> runs;
+    qint32 slots;
+
+    TElementRuns() { slots = 0; }
+    qint32 add(qint32 element);
+    qint32 find(qint32 element) const;
+    bool isDense(qint32 length) const { return slots == length; }
 };
 
 // ==========================================
 // PrimitiveTypeEnumeration
 // ==========================================
 
-class TPrimitiveType
+class TPrimitiveType : public TArenaObject
 {
 public:
     virtual bool read(TBinaryInput&){ return true;}
     virtual void write(QTextStream&) {}
     virtual void writeType(QTextStream&) {}
     virtual TPrimitiveType* clone() { return new TPrimitiveType(*this); }
+    // bytes of the values allocated outside the node
+    virtual qint64 heapSize() { return 0; }
     virtual bool getBool(bool&) { return false; }
     virtual bool getInt(qint64&) { return false; }
     virtual bool getUnsigned(quint64&) { return false; }
@@ -81,10 +454,14 @@ public:
     virtual bool getFloat(float&) { return false; }
     virtual bool getString(QString&) { return false; }
     virtual bool getDateTime(QDateTime&) { return false; }
+    virtual bool getDecimal(TDecimal&) { return false; }
 
     virtual bool getBoolArray(bool**, int&) { return false; }
     virtual bool getInt32Array(qint32**, int&) { return false; }
     virtual bool getDoubleArray(double**, int&) { return false; }
+    virtual bool getDecimalArray(TDecimal**, int&) { return false; }
+    virtual bool getDateTimeArray(TDateTimeValue**, int&) { return false; }
+    virtual bool getTimeSpanArray(TTimeSpanValue**, int&) { return false; }
     virtual bool getObjectArray(TBinaryObject***, int&)  { return false; }
     virtual ~TPrimitiveType() { }
 };
@@ -139,13 +516,14 @@ class TPrimitiveDecimal : public TPrimitiveType
 public:
     // in file as string
 
-    double value;
+    TDecimal value;
 
     bool read(TBinaryInput& input) override;
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TPrimitiveDecimal* clone() { return new TPrimitiveDecimal(*this); }
-    bool getDouble(double& result) override { result = value; return true; }
+    bool getDouble(double& result) override { result = value.toDouble(); return true; }
+    bool getDecimal(TDecimal& result) override { result = value; return true; }
 };
 
 // --------- 6 ------------
@@ -237,13 +615,13 @@ public:
     // in file as 64 bit int
     // specifies duration as int number of 100 nanoseconds
 
-    qint64 value;
+    TTimeSpanValue value;
 
     bool read(TBinaryInput& input) override;
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TPrimitiveTimeSpan* clone() { return new TPrimitiveTimeSpan(*this); }
-    bool getInt(qint64& result) override { result = value; return true; }
+    bool getInt(qint64& result) override { result = value.ticks; return true; }
 };
 
 // --------- 13 ------------
@@ -254,13 +632,13 @@ public:
     // 2 bit time zone: 0 none, 1 utc, 2 local
     // specifies duration as int number of 100 nanoseconds since jan 0001
 
-    QDateTime datetime;
+    TDateTimeValue value;
 
     bool read(TBinaryInput& input) override;
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TPrimitiveDateTime* clone() { return new TPrimitiveDateTime(*this); }
-    bool getDateTime(QDateTime& result) { result = datetime; return true; }
+    bool getDateTime(QDateTime& result) override { result = value.toDateTime(); return true; }
 };
 
 // --------- 14 ------------
@@ -330,10 +708,13 @@ public:
 // SearchType
 // ==========================================
 
-class TSearchType
+class TSearchType : public TArenaObject
 {
 public:
     virtual TBinaryType* getMember(int&, QStringList&) { return NULL; }
+    // true if the member is kept in its class's columns
+    // it has no node, so its value is loaded instead
+    virtual bool getColumnMember(int&, QStringList&, TValue&) { return false; }
 
     virtual bool getBool(bool&) { return false; }
     virtual bool getInt(qint64&) { return false; }
@@ -342,10 +723,14 @@ public:
     virtual bool getFloat(float&) { return false; }
     virtual bool getString(QString&) { return false; }
     virtual bool getDateTime(QDateTime&) { return false; }
+    virtual bool getDecimal(TDecimal&) { return false; }
 
     virtual bool getBoolArray(bool**, int&) { return false; }
     virtual bool getInt32Array(qint32**, int&) { return false; }
     virtual bool getDoubleArray(double**, int&) { return false; }
+    virtual bool getDecimalArray(TDecimal**, int&) { return false; }
+    virtual bool getDateTimeArray(TDateTimeValue**, int&) { return false; }
+    virtual bool getTimeSpanArray(TTimeSpanValue**, int&) { return false; }
     virtual bool getStringArray(QStringList&) { return false; }
     virtual bool getObjectArray(TBinaryObject***, int&)  { return false; }
 
@@ -365,16 +750,23 @@ public:
 
     TBinaryType();
     virtual ~TBinaryType();
-    virtual bool read(TBinaryInput&, QList<TFileRecord*>&){ return true;}
+    virtual bool read(TBinaryInput&, TRecordList&){ return true;}
     virtual bool readAdditional(TBinaryInput&){ return true;}
     virtual void writeType(QTextStream&) {}
-    virtual TBinaryType* cloneType() {return NULL;}
+    virtual TBinaryType* cloneType(TArena*) {return NULL;}
+    virtual char primitiveType() { return 0; }
+    // the node and the bytes it holds, see TMemoryStats
+    virtual qint64 memorySize() { return nodeSize(this); }
 
     TBinaryType* getMember(int& index, QStringList& arglist) override;
+    bool getColumnMember(int& index, QStringList& arglist, TValue& value) override;
 
     bool getBoolArray(bool**, int&) override;
     bool getInt32Array(qint32**, int&) override;
     bool getDoubleArray(double**, int&) override;
+    bool getDecimalArray(TDecimal**, int&) override;
+    bool getDateTimeArray(TDateTimeValue**, int&) override;
+    bool getTimeSpanArray(TTimeSpanValue**, int&) override;
     bool getStringArray(QStringList&) override;
     bool getObjectArray(TBinaryObject***, int&);
 
@@ -385,22 +777,25 @@ public:
     bool getFloat(float& result) override;
     bool getString(QString& result) override;
     bool getDateTime(QDateTime& result) override;
+    bool getDecimal(TDecimal& result) override;
 };
 
 // --------- 0 ------------
 class TBinaryPrimitive : public TBinaryType
 {
 public:
+    // value held in place, no object per member
     char typeEnum;
-    TPrimitiveType* value;
+    TValue value;
 
     TBinaryPrimitive();
-    ~TBinaryPrimitive();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     bool readAdditional(TBinaryInput& input) override;
     void write(QTextStream& outstr, int indent) override;
     void writeType(QTextStream& outstr) override;
-    TBinaryType* cloneType() override;
+    TBinaryType* cloneType(TArena* arena) override;
+    char primitiveType() override { return typeEnum; }
+    qint64 memorySize() override { return nodeSize(this) + value.heapSize(); }
 
     bool getBool(bool& result) override;
     bool getInt(qint64& result) override;
@@ -409,6 +804,7 @@ public:
     bool getFloat(float& result) override;
     bool getString(QString& result) override;
     bool getDateTime(QDateTime& result) override;
+    bool getDecimal(TDecimal& result) override;
 };
 
 // --------- 1 ------------
@@ -419,11 +815,12 @@ public:
     QString value;
 
     TBinaryString();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
-    bool readNoRef(char ref, TBinaryInput& input, QList<TFileRecord*>& recordList);
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
+    bool readNoRef(char ref, TBinaryInput& input, TRecordList& recordList);
     void write(QTextStream& outstr, int indent) override;
     void writeType(QTextStream& outstr) override;
-    TBinaryType* cloneType() override;
+    TBinaryType* cloneType(TArena* arena) override;
+    qint64 memorySize() override { return nodeSize(this) + value.capacity() * sizeof(QChar); }
     bool getString(QString& result) override;
 };
 
@@ -432,11 +829,11 @@ class TBinaryObject : public TBinaryType
 {
 public:
     TBinaryObject();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
-    bool readNoRef(char ref, TBinaryInput& input, QList<TFileRecord*>& recordList);
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
+    bool readNoRef(char ref, TBinaryInput& input, TRecordList& recordList);
     void write(QTextStream& outstr, int indent) override;
     void writeType(QTextStream& outstr) override;
-    TBinaryType* cloneType() override;
+    TBinaryType* cloneType(TArena* arena) override;
 };
 
 // --------- 3 ------------
@@ -446,11 +843,12 @@ public:
     QString name;
 
     TBinarySystemClass();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     bool readAdditional(TBinaryInput& input) override;
     void write(QTextStream& outstr, int indent) override;
     void writeType(QTextStream& outstr) override;
-    TBinaryType* cloneType() override;
+    TBinaryType* cloneType(TArena* arena) override;
+    qint64 memorySize() override { return nodeSize(this) + name.capacity() * sizeof(QChar); }
 };
 
 // --------- 4 ------------
@@ -461,11 +859,12 @@ public:
     qint32 libraryID;
 
     TBinaryClass();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     bool readAdditional(TBinaryInput& input) override;
     void write(QTextStream& outstr, int indent) override;
     void writeType(QTextStream& outstr) override;
-    TBinaryType* cloneType() override;
+    TBinaryType* cloneType(TArena* arena) override;
+    qint64 memorySize() override { return nodeSize(this) + name.capacity() * sizeof(QChar); }
 };
 
 // --------- 5 ------------
@@ -473,10 +872,10 @@ class TBinaryObjectArray : public TBinaryType
 {
 public:
     TBinaryObjectArray();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
     void writeType(QTextStream& outstr) override;
-    TBinaryType* cloneType() override;
+    TBinaryType* cloneType(TArena* arena) override;
 };
 
 // --------- 6 ------------
@@ -484,10 +883,10 @@ class TBinaryStringArray : public TBinaryType
 {
 public:
     TBinaryStringArray();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
     void writeType(QTextStream& outstr) override;
-    TBinaryType* cloneType() override;
+    TBinaryType* cloneType(TArena* arena) override;
 };
 
 // --------- 7 ------------
@@ -498,11 +897,11 @@ public:
 
     TBinaryPrimitiveArray();
     ~TBinaryPrimitiveArray();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     bool readAdditional(TBinaryInput& input) override;
     void write(QTextStream& outstr, int indent) override;
     void writeType(QTextStream& outstr) override;
-    TBinaryType* cloneType() override;
+    TBinaryType* cloneType(TArena* arena) override;
 };
 
 // ==========================================
@@ -520,8 +919,9 @@ public:
 
     TFileRecord();
     virtual ~TFileRecord();
-    virtual bool read(TBinaryInput&, QList<TFileRecord*>&){ return true; }
+    virtual bool read(TBinaryInput&, TRecordList&){ return true; }
     virtual void getReferences(QList<TBinaryType*>& list);
+    virtual qint64 memorySize();
 
     TBinaryType* getMember(int& index, QStringList& arglist) override;
 };
@@ -536,7 +936,7 @@ public:
     qint32 minorVersion;
 
     TSerializedStreamHeader();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
 };
 
@@ -544,12 +944,23 @@ public:
 class TClassWithId : public TFileRecord
 {
 public:
+    // with columns, the fixed size primitive members are in row of columns
+    // and memberList only holds the other members
     qint32 metadataID;
-    TFileRecord* metadataRecord;
+    TClassSchema* schema;
+    TClassColumns* columns;
+    int row;
 
     TClassWithId();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
+    TBinaryType* getMember(int& index, QStringList& arglist) override;
+    bool getColumnMember(int& index, QStringList& arglist, TValue& value) override;
+    TBinaryType* memberAt(int i);
+    qint64 memorySize() override;
+
+private:
+    int memberIndex(int& index, QStringList& arglist);
 };
 
 // --------- 2 ------------
@@ -558,7 +969,7 @@ class TSystemClassWithMembers : public TFileRecord
 public:
 
     TSystemClassWithMembers();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
 };
 
@@ -569,7 +980,7 @@ public:
     qint32 libraryID;
 
     TClassWithMembers();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
 };
 
@@ -578,10 +989,12 @@ class TSystemClassWithMembersAndTypes : public TFileRecord
 {
 public:
     qint32 libraryID;
+    TClassSchema* schema;
 
     TSystemClassWithMembersAndTypes();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
+    qint64 memorySize() override;
 };
 
 // --------- 5 ------------
@@ -589,56 +1002,64 @@ class TClassWithMembersAndTypes : public TFileRecord
 {
 public:
     qint32 libraryID;
+    TClassSchema* schema;
 
     TClassWithMembersAndTypes();
     ~TClassWithMembersAndTypes();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
+    qint64 memorySize() override;
 };
 
 // --------- 6 ------------
 class TBinaryObjectString : public TFileRecord
 {
 public:
-    QString value;
+    // kept as utf8, converted by getString
+    QByteArray utf8;
 
     TBinaryObjectString();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
     bool getString(QString& str);
+    qint64 memorySize() override;
 };
 
 // --------- 7 ------------
 class TBinaryArray : public TFileRecord
 {
 public:
+    // only elements that are not null are kept, see TElementRuns
     char arrayType;
     qint32 rank;
     qint32* lengths;
     qint32* lowerBounds;
     TBinaryType* remoteType;
-    TBinaryObject** array;
+    TElementRuns runs;
+    QVector<TBinaryObject*> objects;
     int arraySize;
     int* offset;
 
     TBinaryArray();
     ~TBinaryArray();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
     void getReferences(QList<TBinaryType*>& btlist) override;
     TBinaryType* getMember(int& index, QStringList& arglist) override;
+    TBinaryObject* at(qint32 i);
+    qint64 memorySize() override;
 };
 
 // --------- 8 ------------
 class TMemberPrimitiveTyped : public TFileRecord
 {
 public:
-    TPrimitiveType* value;
+    TValue value;
 
     TMemberPrimitiveTyped();
-    ~TMemberPrimitiveTyped();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList);
+    bool read(TBinaryInput& input, TRecordList& recordList);
     void write(QTextStream& outstr, int indent) override;
+    qint64 memorySize() override;
 };
 
 // --------- 9 ------------
@@ -647,7 +1068,7 @@ class TMemberReference : public TFileRecord
 public:
 
     TMemberReference();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
     void getReferences(QList<TBinaryType*>& btlist) override;
 };
@@ -658,7 +1079,7 @@ class TObjectNull : public TFileRecord
 public:
 
     TObjectNull();
-    bool read(TBinaryInput&, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput&, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
 };
 
@@ -668,7 +1089,7 @@ class TMessageEnd : public TFileRecord
 public:
 
     TMessageEnd();
-    bool read(TBinaryInput&, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput&, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
 };
 
@@ -680,8 +1101,9 @@ public:
     QString libraryName;
 
     TBinaryLibrary();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList);
+    bool read(TBinaryInput& input, TRecordList& recordList);
     void write(QTextStream& outstr, int indent) override;
+    qint64 memorySize() override;
 };
 
 // --------- 13 ------------
@@ -691,7 +1113,7 @@ public:
     int nullCount;
 
     TObjectNullMultiple256();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
 };
 
@@ -702,7 +1124,7 @@ public:
     qint32 nullCount;
 
     TObjectNullMultiple();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
 };
 
@@ -716,38 +1138,71 @@ public:
 
     TArraySinglePrimitive();
     ~TArraySinglePrimitive();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
+    qint64 memorySize() override;
 
     bool getBoolArray(bool**, int&) override;
     bool getInt32Array(qint32**, int&) override;
     bool getDoubleArray(double**, int&) override;
+    bool getDecimalArray(TDecimal**, int&) override;
+    bool getDateTimeArray(TDateTimeValue**, int&) override;
+    bool getTimeSpanArray(TTimeSpanValue**, int&) override;
     bool getObjectArray(TBinaryObject***, int&);
 };
 
 // --------- 16 ------------
+// element tags, kept in char so they stay positive
+// whether char is signed or not, and clear of the primitive types 1..18
+#define ELEMENT_NULL 0
+#define ELEMENT_OBJECT 0x40
+#define ELEMENT_MIXED 0x41
+
 class TArraySingleObject : public TFileRecord
 {
 public:
+    // only elements that are not null are kept, in slots, see TElementRuns
+    // typeArray has a tag per slot: object or its primitive type
+    // elementType is the tag of all slots, mixed once they differ
+    // one fixed size primitive type is packed in values, objects only in objectArray
+    // anything else gets an 8 byte cell per slot holding the value or a pointer
+
     qint32 length;
-    TBinaryObject** objectArray;
-    char* typeArray;
-    double* doubleArray;
-    qint32* int32Array;
-    qint64* int64Array;
-    bool* boolArray;
+    char elementType;
+    TElementRuns runs;
+    QByteArray typeArray;
+    QByteArray values;
+    QVector<TBinaryObject*> objectArray;
+    QVector<quint64> cells;
 
     TArraySingleObject();
     ~TArraySingleObject();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
     void getReferences(QList<TBinaryType*>& btlist) override;
     TBinaryType* getMember(int &index, QStringList &arglist) override;
+    qint64 memorySize() override;
 
     bool getBoolArray(bool** array, int& len) override;
     bool getInt32Array(qint32** array, int& len) override;
     bool getDoubleArray(double** array, int& len) override;
+    bool getDateTimeArray(TDateTimeValue** array, int& len) override;
+    bool getTimeSpanArray(TTimeSpanValue** array, int& len) override;
+    bool getStringArray(QStringList& list) override;
     bool getObjectArray(TBinaryObject*** array, int& len) override;
+
+private:
+    // whole arrays by element for the getters, made when there are nulls
+    char* expanded;
+    TBinaryObject** expandedObjects;
+
+    bool readPrimitive(TBinaryInput& input, int i, char type);
+    qint32 addSlot(qint32 element, char tag);
+    bool usesCells();
+    void toCells();
+    char* valueAt(qint32 slot);
+    TBinaryObject* objectAt(qint32 slot);
+    char* elementValues(char type);
 };
 
 // --------- 17 ------------
@@ -756,7 +1211,7 @@ class TArraySingleString : public TFileRecord
 public:
     TArraySingleString();
     ~TArraySingleString();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
     bool getStringArray(QStringList&) override;
 };
@@ -772,7 +1227,7 @@ public:
     QList<TPrimitiveType*> args;
 
     TMethodCall();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
 };
 
@@ -787,7 +1242,7 @@ public:
     QList<TPrimitiveType*> args;
 
     TMethodReturn();
-    bool read(TBinaryInput& input, QList<TFileRecord*>& recordList) override;
+    bool read(TBinaryInput& input, TRecordList& recordList) override;
     void write(QTextStream& outstr, int indent) override;
 };
 
@@ -809,6 +1264,7 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayBoolean* clone() { return new TArrayBoolean(*this); }
+    qint64 heapSize() override { return (qint64)length * sizeof(bool); }
     bool getBoolArray(bool** array, int& len);
 };
 
@@ -818,6 +1274,7 @@ class TArrayByte : public TPrimitiveType
 public:
     char* value;
     qint32 length;
+    bool owned;
 
     TArrayByte(int len);
     ~TArrayByte();
@@ -825,6 +1282,7 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayByte* clone() { return new TArrayByte(*this); }
+    qint64 heapSize() override { return owned ? (qint64)length * sizeof(*value) : 0; }
 };
 
 // --------- 3 ------------
@@ -842,6 +1300,7 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayChar* clone() { return new TArrayChar(*this); }
+    qint64 heapSize() override { return (qint64)value.capacity() * sizeof(QChar); }
 };
 
 // --------- 5 ------------
@@ -849,7 +1308,9 @@ class TArrayDecimal : public TPrimitiveType
 {
 public:
     // in file as string
-    double* value;
+    // doubles is made from value by the first getDoubleArray
+    TDecimal* value;
+    double* doubles;
     qint32 length;
 
     TArrayDecimal(int len);
@@ -858,7 +1319,9 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayDecimal* clone() { return new TArrayDecimal(*this); }
-    bool getDoubleArray(double** array, int& len);
+    qint64 heapSize() override { return (qint64)length * (sizeof(TDecimal) + (doubles != NULL ? sizeof(double) : 0)); }
+    bool getDoubleArray(double** array, int& len) override;
+    bool getDecimalArray(TDecimal** array, int& len) override;
 };
 
 // --------- 6 ------------
@@ -868,6 +1331,7 @@ public:
     // in file as 64 bit
     double* value;
     qint32 length;
+    bool owned;
 
     TArrayDouble(int len);
     ~TArrayDouble();
@@ -875,6 +1339,7 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayDouble* clone() { return new TArrayDouble(*this); }
+    qint64 heapSize() override { return owned ? (qint64)length * sizeof(*value) : 0; }
     bool getDoubleArray(double** array, int& len);
 };
 
@@ -884,6 +1349,7 @@ class TArrayInt16 : public TPrimitiveType
 public:
     qint16* value;
     qint32 length;
+    bool owned;
 
     TArrayInt16(int len);
     ~TArrayInt16();
@@ -891,6 +1357,7 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayInt16* clone() { return new TArrayInt16(*this); }
+    qint64 heapSize() override { return owned ? (qint64)length * sizeof(*value) : 0; }
 };
 
 // --------- 8 ------------
@@ -899,6 +1366,7 @@ class TArrayInt32 : public TPrimitiveType
 public:
     qint32* value;
     qint32 length;
+    bool owned;
 
     TArrayInt32(int len);
     ~TArrayInt32();
@@ -906,6 +1374,7 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayInt32* clone() { return new TArrayInt32(*this); }
+    qint64 heapSize() override { return owned ? (qint64)length * sizeof(*value) : 0; }
     bool getInt32Array(qint32** array, int& len);
 };
 
@@ -915,6 +1384,7 @@ class TArrayInt64 : public TPrimitiveType
 public:
     qint64* value;
     qint32 length;
+    bool owned;
 
     TArrayInt64(int len);
     ~TArrayInt64();
@@ -922,6 +1392,7 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayInt64* clone() { return new TArrayInt64(*this); }
+    qint64 heapSize() override { return owned ? (qint64)length * sizeof(*value) : 0; }
 };
 
 // --------- 10 ------------
@@ -930,6 +1401,7 @@ class TArraySByte : public TPrimitiveType
 public:
     char* value;
     qint32 length;
+    bool owned;
 
     TArraySByte(int len);
     ~TArraySByte();
@@ -937,6 +1409,7 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArraySByte* clone() { return new TArraySByte(*this); }
+    qint64 heapSize() override { return owned ? (qint64)length * sizeof(*value) : 0; }
 };
 
 // --------- 11 ------------
@@ -946,6 +1419,7 @@ public:
     // in file as 32 bit float
     float* value;
     qint32 length;
+    bool owned;
 
     TArraySingle(int len);
     ~TArraySingle();
@@ -953,6 +1427,7 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArraySingle* clone() { return new TArraySingle(*this); }
+    qint64 heapSize() override { return owned ? (qint64)length * sizeof(*value) : 0; }
 };
 
 // --------- 12 ------------
@@ -961,8 +1436,9 @@ class TArrayTimeSpan : public TPrimitiveType
 public:
     // in file as 64 bit int
     // specifies duration as int number of 100 nanoseconds
-    qint64* value;
+    TTimeSpanValue* value;
     qint32 length;
+    bool owned;
 
     TArrayTimeSpan(int len);
     ~TArrayTimeSpan();
@@ -970,6 +1446,8 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayTimeSpan* clone() { return new TArrayTimeSpan(*this); }
+    qint64 heapSize() override { return owned ? (qint64)length * sizeof(*value) : 0; }
+    bool getTimeSpanArray(TTimeSpanValue** array, int& len) override;
 };
 
 // --------- 13 ------------
@@ -979,8 +1457,9 @@ public:
     // in file as 62 bit int
     // 2 bit time zone: 0 none, 1 utc, 2 local
     // specifies duration as int number of 100 nanoseconds since jan 0001
-    qint64* value;
+    TDateTimeValue* value;
     qint32 length;
+    bool owned;
 
     TArrayDateTime(int len);
     ~TArrayDateTime();
@@ -988,6 +1467,8 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayDateTime* clone() { return new TArrayDateTime(*this); }
+    qint64 heapSize() override { return owned ? (qint64)length * sizeof(*value) : 0; }
+    bool getDateTimeArray(TDateTimeValue** array, int& len) override;
 };
 
 // --------- 14 ------------
@@ -996,6 +1477,7 @@ class TArrayUInt16 : public TPrimitiveType
 public:
     quint16* value;
     qint32 length;
+    bool owned;
 
     TArrayUInt16(int len);
     ~TArrayUInt16();
@@ -1003,6 +1485,7 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayUInt16* clone() { return new TArrayUInt16(*this); }
+    qint64 heapSize() override { return owned ? (qint64)length * sizeof(*value) : 0; }
 };
 
 // --------- 15 ------------
@@ -1011,6 +1494,7 @@ class TArrayUInt32 : public TPrimitiveType
 public:
     quint32* value;
     qint32 length;
+    bool owned;
 
     TArrayUInt32(int len);
     ~TArrayUInt32();
@@ -1018,6 +1502,7 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayUInt32* clone() { return new TArrayUInt32(*this); }
+    qint64 heapSize() override { return owned ? (qint64)length * sizeof(*value) : 0; }
 };
 
 // --------- 16 ------------
@@ -1026,6 +1511,7 @@ class TArrayUInt64 : public TPrimitiveType
 public:
     quint64* value;
     qint32 length;
+    bool owned;
 
     TArrayUInt64(int len);
     ~TArrayUInt64();
@@ -1033,6 +1519,7 @@ public:
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayUInt64* clone() { return new TArrayUInt64(*this); }
+    qint64 heapSize() override { return owned ? (qint64)length * sizeof(*value) : 0; }
 };
 
 // --------- 17 ------------
@@ -1053,31 +1540,102 @@ public:
 class TArrayString : public TPrimitiveType
 {
 public:
-    QStringList value;
+    // utf8 of all strings back to back
+    // string i is utf8[offsets[i]] up to offsets[i+1]
+    QByteArray utf8;
+    QVector<qint32> offsets;
     qint32 length;
 
     TArrayString(int len);
     ~TArrayString();
     bool read(TBinaryInput& input) override;
+    QString at(int i);
     void write(QTextStream& outstr) override;
     void writeType(QTextStream& outstr) override;
     TArrayString* clone() { return new TArrayString(*this); }
+    qint64 heapSize() override { return utf8.capacity() + (qint64)offsets.capacity() * sizeof(qint32); }
 };
 
 // ==========================================
 // TBinaryInput
 // ==========================================
 
+// largest single readBytes of an array
+#define ARRAY_READ_CHUNK (1 << 30)
+
+// reverse each size byte element, used on big endian hosts
+void swapBytes(void* data, int count, int size);
+
+// bits in TBinaryInput::flags
+// the bytes stay valid as long as the records read from them
+// string records then reference the input instead of copying it
+// only used by inputs whose persistent() is true, others always copy
+#define INPUT_PERSISTENT 0x1
+// primitive arrays point into the input instead of being copied
+// needs INPUT_PERSISTENT and is also only used if persistent() is true
+#define INPUT_ARRAY_VIEWS 0x2
+
 class TBinaryInput
 {
 public:
+    int flags;
+
+    TBinaryInput() { cursor = NULL; limit = NULL; flags = 0; }
     virtual bool readBytes(char*, int) { return false; }
+    virtual const char* readView(int count);
+    // beginRecord is called before the code byte of each top level record
+    // and setRecordType once that byte is read
+    virtual void beginRecord() {}
+    virtual void setRecordType(char) {}
     virtual ~TBinaryInput() {}
 
-    int readVariableInt();
+    // true if the input holds all its bytes in memory
+    // so views stay valid until it is destroyed, not just until the next read
+    virtual bool persistent() const { return false; }
+
+    // fast path for fixed size fields
+    // reads straight from the buffered window when it holds enough bytes
+    // otherwise falls back to readBytes which refills the window
+    template<typename T> inline bool readValue(T& value) {
+        if(limit - cursor >= (int)sizeof(T)) {
+            memcpy(&value, cursor, sizeof(T));
+            cursor += sizeof(T);
+        }
+        else if(!readBytes((char*)&value, sizeof(T))) {
+            return false;
+        }
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+        swapBytes(&value, 1, sizeof(T));
+#endif
+        return true;
+    }
+    inline bool readU8(quint8& value) { return readValue(value); }
+    inline bool readChar(char& value) { return readValue(value); }
+    inline bool readI32(qint32& value) { return readValue(value); }
+    inline bool readI64(qint64& value) { return readValue(value); }
+    inline bool readDouble(double& value) { return readValue(value); }
+
+    bool readArray(void* buffer, int count, int size);
+    bool readVariableInt(qint32& result);
     bool readString(QString& str);
+    bool readUtf8(QByteArray& bytes);
+    bool readDecimal(TDecimal& value);
+    bool readChars(QString& str, int count);
     bool readStringWithCode(QString& str);
-    bool readArrayOfValueWithCode(QList<TPrimitiveType*>& list);
+    bool readArrayOfValueWithCode(QList<TPrimitiveType*>& list, TArena* arena);
+
+protected:
+    // buffered bytes not yet consumed
+    // empty for inputs that read every field from the device
+    const char* cursor;
+    const char* limit;
+
+    // make at least count bytes available in the window
+    virtual bool fill(int) { return false; }
+
+private:
+    // reused for strings that are not available as a view
+    QByteArray scratch;
 };
 
 class TFileInput : public TBinaryInput
@@ -1091,6 +1649,130 @@ public:
     bool readBytes(char* buffer, int count) override;
 };
 
+#define INPUT_BLOCK_SIZE 65536
+
+class TBufferedFileInput : public TBinaryInput
+{
+public:
+    // reads the file in blocks of blockSize bytes
+    // reads larger than a block go directly to the file
+
+    QFile infile;
+    char* block;
+    int blockSize;
+
+    TBufferedFileInput(QString& filename, int blocksize = INPUT_BLOCK_SIZE);
+    ~TBufferedFileInput();
+    bool open();
+    bool readBytes(char* buffer, int count) override;
+
+protected:
+    bool fill(int count) override;
+};
+
+class TPrefetchFileInput : public TBinaryInput
+{
+public:
+    // double buffered
+    // a worker thread reads the next block while the current one is parsed
+    // waitTime is the total nanoseconds spent waiting for the worker
+
+    QFile infile;
+    int blockSize;
+    qint64 waitTime;
+
+    TPrefetchFileInput(QString& filename, int blocksize = INPUT_BLOCK_SIZE);
+    ~TPrefetchFileInput();
+    bool open();
+    bool readBytes(char* buffer, int count) override;
+
+protected:
+    bool fill(int count) override;
+
+private:
+    class TPrefetchThread;
+
+    TPrefetchThread* thread;
+    QMutex mutex;
+    QWaitCondition changed;
+
+    // each block has blockSize bytes of room in front of the data
+    // for unread bytes carried over from the previous block
+    char* blocks[2];
+    char* current;
+    char* freeBlock;
+    char* readyBlock;
+    int readyCount;
+    bool stopping;
+    bool finished;
+
+    void prefetch();
+    bool nextBlock();
+};
+
+class TGzipFileInput : public TBinaryInput
+{
+public:
+    // gzip or zlib compressed file
+    // inflated a block at a time as the parser needs it
+
+    QFile infile;
+    int blockSize;
+
+    TGzipFileInput(QString& filename, int blocksize = INPUT_BLOCK_SIZE);
+    ~TGzipFileInput();
+    bool open();
+    bool readBytes(char* buffer, int count) override;
+
+protected:
+    bool fill(int count) override;
+
+private:
+    z_stream_s* zstream;
+    char* inBlock;
+    char* block;
+    bool finished;
+    bool memberEnd;
+
+    int inflateBlock(char* buffer, int size);
+};
+
+class TMappedFileInput : public TBinaryInput
+{
+public:
+    // whole file mapped into memory
+    // readView returns pointers into the mapping
+    // which stay valid until the input is destroyed
+
+    QFile infile;
+    const char* data;
+    qint64 size;
+
+    TMappedFileInput(QString& filename);
+    ~TMappedFileInput();
+    bool open();
+    bool readBytes(char* buffer, int count) override;
+    bool persistent() const override { return true; }
+};
+
+class TMemoryInput : public TBinaryInput
+{
+public:
+    // reads from bytes already in memory without copying them
+    // the QByteArray constructor shares the array's data
+    // the pointer constructor needs the caller to keep the data alive
+    // several streams may follow each other in the buffer
+
+    QByteArray bytes;
+    const char* data;
+    qint64 size;
+
+    TMemoryInput(const QByteArray& buffer);
+    TMemoryInput(const char* buffer, qint64 length);
+    bool readBytes(char* buffer, int count) override;
+    bool persistent() const override { return true; }
+};
+
 class TFileInputLog : public TBinaryInput
 {
 public:
@@ -1104,6 +1786,61 @@ public:
     bool readBytes(char* buffer, int count) override;
 };
 
+#define TRACE_RING_SIZE 65536
+
+class TTraceEntry
+{
+public:
+    // one entry in a trace file for each read
+    qint64 offset;
+    qint32 length;
+    qint32 record;      // top level record number, -1 before the first
+    qint8 recordType;
+};
+
+class TFileInputTrace : public TBinaryInput
+{
+public:
+    // low overhead alternative to TFileInputLog
+    // reads are noted in a preallocated ring of TTraceEntry
+    // and a worker thread writes each half of the ring to tracefile
+    // the tracedump tool turns the trace into a hex log
+
+    QFile infile;
+    QFile tracefile;
+    qint64 byteCount;
+
+    TFileInputTrace(QString& filename, QString& tracename, int ringsize = TRACE_RING_SIZE);
+    ~TFileInputTrace();
+    bool open();
+    bool readBytes(char* buffer, int count) override;
+    void beginRecord() override;
+    void setRecordType(char type) override;
+
+private:
+    class TTraceWriter;
+
+    TTraceWriter* writer;
+    QMutex mutex;
+    QWaitCondition changed;
+
+    TTraceEntry* ring;
+    int ringSize;
+    qint64 head;        // entries added by the parser
+    qint64 published;   // entries handed to the writer
+    qint64 tail;        // entries written to the file
+    bool stopping;
+
+    // the code byte is noted before its type is known
+    // and its entry is held back from the writer until setRecordType
+    qint32 record;
+    qint8 recordType;
+    bool typePending;
+
+    void publish();
+    void flush();
+};
+
 // ==========================================
 // Stream
 // ==========================================
@@ -1120,11 +1857,20 @@ public:
     int recordCount();
     TFileRecord* getRecord(int n);
     qint32 associateReferences();
+    qint32 associateReferences(QList<qint32>& unresolved);
     TFileRecord* getClass(const QString& name);
+    TClassColumns* getColumns(const QString& name);
+    TMemoryStats* getMemoryStats() { return &memory; }
+    QString getName(qint32 id) { return recordList.names.name(id); }
+    qint64 memoryUsed() { return memory.total; }
 
 private:
-    QList<TFileRecord*> recordList;
+    TRecordList recordList;
     TSerializedStreamHeader header;
+    TMemoryStats memory;
+    int accounted;
+
+    void addMemory();
 };
 
 
@@ -1141,14 +1887,20 @@ public:
     int read(TBinaryInput& input);
     int streamCount();
     TStream* getStream(int n);
+    qint64 memoryUsed();
     qint32 associateReferences();
+    qint32 associateReferences(QList<qint32>& unresolved);
     void getErrorString(int error, QString& str);
+    // a member kept in a class's columns is loaded into scratch
+    // which is returned, the first form uses one scratch for all calls
     TSearchType* getObject(QStringList& path);
+    TSearchType* getObject(QStringList& path, TBinaryPrimitive& scratch);
     void getLastPath(QString& path);
 
 private:
     QList<TStream*> streamList;
     QStringList lastPath;
+    TBinaryPrimitive scratch;
 
     void clearList();
 };
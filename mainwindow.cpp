@@ -3,6 +3,12 @@
 #include <QFile>
 #include <QFileDialog>
 #include <QTextStream>
+#include <algorithm>
+
+static bool largerArray(const TArrayMemory& a, const TArrayMemory& b)
+{
+    return a.bytes > b.bytes;
+}
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -28,7 +34,7 @@ void MainWindow::on_actionOpen_triggered()
 
     QString logname = inName + ".log";
 
-    TFileInput fileinput(inName);
+    TBufferedFileInput fileinput(inName);
     if(!fileinput.open()) {
         ui->textEdit->append("Failed to open in file");
         return;
@@ -50,26 +56,62 @@ void MainWindow::on_actionOpen_triggered()
 
     int rcount[23];
     memset(rcount, 0, 23*sizeof(int));
+    qint64 rbytes[23];
+    memset(rbytes, 0, 23*sizeof(qint64));
+    QHash<QString, qint64> classBytes;
 
     for(int s=0; s<deserial->streamCount(); s++) {
         TStream* stream = deserial->getStream(s);
-        msg.sprintf("stream %d: %d records", s, stream->recordCount());
+        msg.sprintf("stream %d: %d records %lld bytes", s, stream->recordCount(), stream->memoryUsed());
         ui->textEdit->append(msg);
 
         for(int r=0; r<stream->recordCount(); r++) {
             TFileRecord* rec = stream->getRecord(r);
             rcount[rec->type]++;
         }
+
+        TMemoryStats* memory = stream->getMemoryStats();
+        for(int t=0; t<23; t++) {
+            rbytes[t] += memory->byType[t];
+        }
+        QHash<qint32, qint64>::const_iterator it;
+        for(it = memory->byClass.constBegin(); it != memory->byClass.constEnd(); ++it) {
+            classBytes[stream->getName(it.key())] += it.value();
+        }
     }
 
     for(int t=0; t<23; t++) {
-        msg.sprintf("type %d: %d records", t, rcount[t]);
+        msg.sprintf("type %d: %d records %lld bytes", t, rcount[t], rbytes[t]);
+        ui->textEdit->append(msg);
+    }
+
+    QHash<QString, qint64>::const_iterator it;
+    for(it = classBytes.constBegin(); it != classBytes.constEnd(); ++it) {
+        msg = QString("class %1: %2 bytes").arg(it.key()).arg(it.value());
         ui->textEdit->append(msg);
     }
 
-    result = deserial->associateReferences();
+    // largest primitive arrays of each stream
+    for(int s=0; s<deserial->streamCount(); s++) {
+        QVector<TArrayMemory> arrays = deserial->getStream(s)->getMemoryStats()->arrays;
+        std::sort(arrays.begin(), arrays.end(), largerArray);
+        for(int i=0; i<arrays.count() && i<MAX_ARRAY_PRINT_SIZE; i++) {
+            const TArrayMemory& a = arrays.at(i);
+            msg.sprintf("stream %d array %d type %d length %d: %lld bytes", s, a.objectID, a.typeEnum, a.length, a.bytes);
+            ui->textEdit->append(msg);
+        }
+    }
+
+    msg.sprintf("memory: %lld bytes", deserial->memoryUsed());
+    ui->textEdit->append(msg);
+
+    QList<qint32> unresolved;
+    result = deserial->associateReferences(unresolved);
     if(result != 0) {
-        msg.sprintf("Failed to associate record %d", result);
+        msg.sprintf("%d unresolved ids:", unresolved.count());
+        for(int i=0; i<unresolved.count(); i++) {
+            msg += " " + QString::number(unresolved.at(i));
+        }
         ui->textEdit->append(msg);
     }
     else {
@@ -173,6 +215,27 @@ void MainWindow::on_actionMembers_triggered()
     }
     ui->textEdit->append(str);
 
+    str = "";
+
+    // whole column of a class
+    ts << "0/DeserialTest.SmallClass/smallint column: ";
+
+    TClassColumns* columns = NULL;
+    if(deserial->streamCount() > 0) {
+        columns = deserial->getStream(0)->getColumns("DeserialTest.SmallClass");
+    }
+
+    const qint32* values;
+    int count;
+    if(columns != NULL && columns->getColumn("smallint", &values, count)) {
+        ts << "rows:" << count << " values: ";
+        for(int p=0; p<count && p<MAX_ARRAY_PRINT_SIZE; p++) {
+            ts << values[p] << ", ";
+        }
+    }
+    else ts << "Not found";
+    ui->textEdit->append(str);
+
     str = "";
     path.clear();
 
@@ -240,3 +303,39 @@ void MainWindow::on_actionLog_triggered()
     ui->textEdit->append("Ok");
 
 }
+
+void MainWindow::on_actionTrace_triggered()
+{
+    // open binary
+    // save offsets of reads in tracefile
+    // use tracedump to turn it into a hex log
+    QString inName = QFileDialog::getOpenFileName(this);
+    if (inName.isEmpty()) return;
+
+    QString tracename = inName + ".trace";
+
+    ui->textEdit->append(inName);
+    ui->textEdit->append(tracename);
+
+    TFileInputTrace fileinput(inName, tracename);
+    if(!fileinput.open()) {
+        ui->textEdit->append("Failed to open in file");
+        return;
+    }
+
+    QString msg;
+
+    int result = deserial->read(fileinput);
+
+    if(result != DESERIAL_OK) {
+        deserial->getErrorString(result, msg);
+        msg = "Read failed: " + msg;
+        ui->textEdit->append(msg);
+        return;
+    }
+
+    msg.sprintf("Read %d streams", deserial->streamCount());
+    ui->textEdit->append(msg);
+
+    ui->textEdit->append("Ok");
+}
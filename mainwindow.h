@@ -27,6 +27,8 @@ private slots:
 
     void on_actionLog_triggered();
 
+    void on_actionTrace_triggered();
+
 private:
     Ui::MainWindow *ui;
     TDeserializer* deserial;
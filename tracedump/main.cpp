@@ -0,0 +1,61 @@
+#include "deserializer.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QFile>
+
+// tracedump datafile tracefile logfile
+// writes one line per read: offset, record, record type and the bytes read
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QStringList args = a.arguments();
+    if(args.count() != 4) {
+        QTextStream err(stderr);
+        err << "usage: tracedump datafile tracefile logfile\n";
+        return 1;
+    }
+
+    QFile datafile(args.at(1));
+    QFile tracefile(args.at(2));
+    QFile logfile(args.at(3));
+
+    if(!datafile.open(QFile::ReadOnly) || !tracefile.open(QFile::ReadOnly)) {
+        QTextStream err(stderr);
+        err << "Failed to open in file\n";
+        return 1;
+    }
+    if(!logfile.open(QIODevice::WriteOnly)) {
+        QTextStream err(stderr);
+        err << "Failed to open log file\n";
+        return 1;
+    }
+
+    qint64 size = datafile.size();
+    const uchar* data = datafile.map(0, size);
+    if(data == NULL) {
+        QTextStream err(stderr);
+        err << "Failed to map data file\n";
+        return 1;
+    }
+
+    TTraceEntry entry;
+    QString line;
+    QString hex;
+    while(tracefile.read((char*)&entry, sizeof(TTraceEntry)) == sizeof(TTraceEntry)) {
+        line.sprintf("%.6lld  r%-5d t%-2d  ", entry.offset, entry.record, entry.recordType);
+
+        qint64 end = qMin(entry.offset + entry.length, size);
+        for(qint64 i=entry.offset; i<end; i++) {
+            hex.sprintf("%.2x ", data[i]);
+            line += hex;
+        }
+        line += "\n";
+        logfile.write(line.toUtf8());
+    }
+
+    logfile.close();
+    return 0;
+}
@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# Renders a trace written by TFileInputTrace
+# as a hex log like TFileInputLog
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = tracedump
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += main.cpp
+
+HEADERS  += ../deserializer.h